@@ -110,7 +110,7 @@ uint32_t LibraryAccess::getAlbumCount()
 	return 0;
 }
 
-void LibraryAccess::getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber)
+void LibraryAccess::getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 	if (m_Library.get())
@@ -119,7 +119,7 @@ void LibraryAccess::getTrackAsync(const std::string& id, utils::ISubscriber<cons
 	}
 }
 
-void LibraryAccess::getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void LibraryAccess::getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 	if (m_Library.get())
@@ -128,7 +128,7 @@ void LibraryAccess::getTracksFromAlbumAsync(const std::string& albumId, utils::I
 	}
 }
 
-void LibraryAccess::getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void LibraryAccess::getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 	if (m_Library.get())
@@ -137,7 +137,7 @@ void LibraryAccess::getFirstTrackFromAlbum(const std::string& albumId, utils::IS
 	}
 }
 
-void LibraryAccess::getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void LibraryAccess::getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 	if (m_Library.get())
@@ -146,7 +146,7 @@ void LibraryAccess::getFirstTrackFromAlbumAsync(const std::string& albumId, util
 	}
 }
 
-void LibraryAccess::getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber)
+void LibraryAccess::getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
 	if (m_Library.get())
@@ -164,6 +164,15 @@ void LibraryAccess::getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber)
 	}
 }
 
+void LibraryAccess::getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Library.get())
+	{
+		m_Library->getAlbumsAsync(subscriber, order);
+	}
+}
+
 void LibraryAccess::getRandomTracksAsync(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
@@ -182,6 +191,24 @@ void LibraryAccess::getRandomAlbumAsync(utils::ISubscriber<const Track&>& subscr
 	}
 }
 
+void LibraryAccess::cancelRequests(utils::ISubscriber<const Track&>& subscriber)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Library.get())
+	{
+		m_Library->cancelRequests(subscriber);
+	}
+}
+
+void LibraryAccess::cancelRequests(utils::ISubscriber<const Album&>& subscriber)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Library.get())
+	{
+		m_Library->cancelRequests(subscriber);
+	}
+}
+
 bool LibraryAccess::getAlbumArt(const Album& album, AlbumArt& art)
 {
     std::lock_guard<std::mutex> lock(m_Mutex);
@@ -22,6 +22,7 @@
 
 #include "utils/types.h"
 #include "utils/subscriber.h"
+#include "MusicLibrary/itemid.h"
 #include "MusicLibrary/musiclibraryfactory.h"
 
 namespace Gejengel
@@ -32,6 +33,7 @@ class IScanSubscriber;
 class ILibrarySubscriber;
 class Track;
 class Album;
+struct AlbumOrder;
 class AlbumArt;
 class LibrarySource;
 
@@ -49,16 +51,19 @@ public:
 	uint32_t getTrackCount();
 	uint32_t getAlbumCount();
 
-	void getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber);
-	void getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+	void getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber);
+	void getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
 
-	void getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
-	void getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+	void getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
+	void getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
 
-	void getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber);
+	void getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber);
 	void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber);
+	void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order);
 	void getRandomTracksAsync(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber);
 	void getRandomAlbumAsync(utils::ISubscriber<const Track&>& subscriber);
+	void cancelRequests(utils::ISubscriber<const Track&>& subscriber);
+	void cancelRequests(utils::ISubscriber<const Album&>& subscriber);
 
 	bool getAlbumArt(const Album& album, AlbumArt& art);
 
@@ -25,6 +25,7 @@
 
 #include <fstream>
 #include <cassert>
+#include <algorithm>
 
 using namespace std;
 using namespace utils;
@@ -83,7 +84,7 @@ void PlayQueue::loadQueueFromFile()
                 
                 if (!id.empty())
                 {
-                    queueTrack(id);
+                    queueTrack(ItemId::parse(id));
                 }
             }
         }
@@ -144,7 +145,7 @@ void PlayQueue::queueTrack(const Track& track, int32_t index)
 
             if (iter == m_Tracks.end())
             {
-                index = m_Tracks.size();
+                listIndex = m_Tracks.size();
             }
 
             m_Tracks.insert(iter, queueItem);
@@ -164,7 +165,7 @@ void PlayQueue::queueTrack(const Track& track, int32_t index)
     }
 }
 
-void PlayQueue::queueTrack(const std::string& id, int32_t index)
+void PlayQueue::queueTrack(const ItemId& id, int32_t index)
 {
     try
     {
@@ -180,7 +181,7 @@ void PlayQueue::queueTrack(const std::string& id, int32_t index)
     }
 }
 
-void PlayQueue::queueAlbum(const std::string& id, int32_t index)
+void PlayQueue::queueAlbum(const ItemId& id, int32_t index)
 {
     try
     {
@@ -229,7 +230,7 @@ std::shared_ptr<audio::ITrack> PlayQueue::dequeueNextTrack()
     std::lock_guard<std::recursive_mutex> lock(m_TracksMutex);
     if (m_Tracks.empty())
     {
-        return false;
+        return nullptr;
     }
 
     m_CurrentTrack = m_Tracks.front();
@@ -337,8 +338,12 @@ bool PlayQueue::getTrackInfo(uint32_t index, Track& track)
 
 void PlayQueue::clear()
 {
+    // tracks that were requested but not delivered yet should not end up in the cleared queue
+    m_Core.getLibraryAccess().cancelRequests(*this);
+
     std::lock_guard<std::recursive_mutex> lock(m_TracksMutex);
     m_Tracks.clear();
+    m_IndexMap.clear();
     notifyQueueCleared();
 }
 
@@ -69,8 +69,8 @@ public:
     virtual ~PlayQueue();
 
     void queueTrack(const Track& track, int32_t index = -1);
-    void queueTrack(const std::string& id, int32_t index = -1);
-    void queueAlbum(const std::string& id, int32_t index = -1);
+    void queueTrack(const ItemId& id, int32_t index = -1);
+    void queueAlbum(const ItemId& id, int32_t index = -1);
 
     void queueRandomTracks(uint32_t count);
     void queueRandomAlbum();
@@ -108,7 +108,7 @@ private:
     std::list<std::shared_ptr<PlayQueueItem>>   m_Tracks;
     std::vector<PlayQueueSubscriber*>           m_Subscribers;
     int32_t                                     m_QueueIndex;
-    std::map<std::string, int32_t>              m_IndexMap;
+    std::map<ItemId, int32_t>                   m_IndexMap;
     
     std::shared_ptr<PlayQueueItem>              m_CurrentTrack; //the last popped track
 
@@ -31,7 +31,7 @@ namespace Gejengel
 class Album : public LibraryItem
 {
 public:
-    Album(const std::string& id = "")
+    Album(const ItemId& id = ItemId())
     : LibraryItem(id)
     , year(0), trackCount(0), discCount(0), durationInSec(0), fileSize(0), dateAdded(0)
     {}
@@ -53,6 +53,24 @@ public:
 
 std::ostream& operator<<(std::ostream& os, const Album& item);
 
+// Order of an album listing, the pages of a paged listing follow it
+struct AlbumOrder
+{
+    enum Column
+    {
+        Title,
+        Artist,
+        DateAdded
+    };
+
+    AlbumOrder(Column col = Title, bool desc = false)
+    : column(col), descending(desc)
+    {}
+
+    Column  column;
+    bool    descending;
+};
+
 }
 
 #endif
@@ -27,7 +27,7 @@ AlbumArt::AlbumArt()
 {
 }
 
-AlbumArt::AlbumArt(const std::string& albumId)
+AlbumArt::AlbumArt(const ItemId& albumId)
 : m_AlbumId(albumId)
 {
 }
@@ -57,7 +57,7 @@ uint32_t AlbumArt::getDataSize() const
 	return m_Art.data.size();
 }
 
-std::string AlbumArt::getAlbumId() const
+const ItemId& AlbumArt::getAlbumId() const
 {
 	return m_AlbumId;
 }
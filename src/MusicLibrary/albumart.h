@@ -20,6 +20,7 @@
 #include <vector>
 #include <string>
 
+#include "itemid.h"
 #include "utils/types.h"
 #include "audio/audiometadata.h"
 
@@ -30,7 +31,7 @@ class AlbumArt
 {
 public:
 	AlbumArt();
-	AlbumArt(const std::string& albumId);
+	AlbumArt(const ItemId& albumId);
 
     void setAlbumArt(audio::Metadata::AlbumArt&& art);
     void setAlbumArt(const audio::Metadata::AlbumArt& art);
@@ -38,10 +39,10 @@ public:
 	std::vector<uint8_t>& getData();
 	const std::vector<uint8_t>& getData() const;
 	uint32_t getDataSize() const;
-	std::string getAlbumId() const;
+	const ItemId& getAlbumId() const;
 
 private:
-	std::string                 m_AlbumId;
+	ItemId                      m_AlbumId;
 	audio::Metadata::AlbumArt   m_Art;
 };
 
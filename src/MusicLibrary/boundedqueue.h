@@ -0,0 +1,99 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+#include "utils/types.h"
+
+namespace Gejengel
+{
+
+// Hands items from one stage of a pipeline to the next. push blocks while
+// the queue is full so a fast stage can't run ahead of a slow one.
+// Once the queue is closed push fails and pop fails as soon as the
+// remaining items are taken.
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(size_t capacity)
+    : m_Capacity(capacity)
+    , m_Closed(false)
+    {
+    }
+
+    bool push(T&& item)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_NotFull.wait(lock, [this] () { return m_Closed || m_Items.size() < m_Capacity; });
+        if (m_Closed)
+        {
+            return false;
+        }
+
+        m_Items.push_back(std::move(item));
+        m_NotEmpty.notify_one();
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_NotEmpty.wait(lock, [this] () { return m_Closed || !m_Items.empty(); });
+        if (m_Items.empty())
+        {
+            return false;
+        }
+
+        item = std::move(m_Items.front());
+        m_Items.pop_front();
+        m_NotFull.notify_one();
+        return true;
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Closed = true;
+        m_NotFull.notify_all();
+        m_NotEmpty.notify_all();
+    }
+
+    // discards the remaining items and opens the queue again
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Items.clear();
+        m_Closed = false;
+    }
+
+private:
+    std::deque<T>               m_Items;
+    size_t                      m_Capacity;
+    bool                        m_Closed;
+    std::mutex                  m_Mutex;
+    std::condition_variable     m_NotFull;
+    std::condition_variable     m_NotEmpty;
+};
+
+}
+
+#endif
@@ -18,32 +18,70 @@
 
 #include <stdexcept>
 #include <cassert>
+#include <iterator>
+#include <algorithm>
 
+#include "config.h"
 #include "Core/settings.h"
 #include "track.h"
 #include "album.h"
 #include "scanner.h"
 #include "utils/log.h"
 #include "utils/trace.h"
+#include "utils/fileoperations.h"
 
 using namespace std;
 
 namespace Gejengel
 {
 
+static const uint32_t FIRST_ALBUM_PAGE_SIZE = 100;
+static const uint32_t ALBUM_PAGE_SIZE = 500;
+
+// the maintenance only starts when no library requests were made for a while
+static const std::chrono::seconds MAINTENANCE_IDLE_TIME(60);
+static const std::chrono::seconds MAINTENANCE_CHECK_INTERVAL(30);
+
 FilesystemMusicLibrary::FilesystemMusicLibrary(const Settings& settings)
 : MusicLibrary(settings)
-, m_Db(settings.get("DBFile"))
+, m_Db(settings.get("DBFile"), settings.getAsInt("DbReadConnections", 4))
+, m_Requests(settings.getAsInt("DbRequestThreads", 2))
+, m_LastAlbumListing(0)
+, m_Scanning(false)
+, m_WatchStopped(false)
 , m_Destroy(false)
 {
     utils::trace("Create FilesystemMusicLibrary");
     m_Db.setSubscriber(*this);
+
+    if (settings.getAsBool("DbProfiling", false))
+    {
+        m_Db.setQueryProfiling(true, settings.getAsInt("DbProfilingLogInterval", 300));
+    }
+
+    m_MaintenanceThread = std::thread(&FilesystemMusicLibrary::maintenanceThread, this,
+                                      settings.getAsInt("DbMaintenanceInterval", 24 * 3600),
+                                      settings.getAsInt("DbMaintenanceTimeBudget", 1000));
+
+    // the library of the previous session is kept up to date without a rescan
+    m_LibraryPath = settings.get("MusicLibrary");
+    startWatching();
 }
 
 FilesystemMusicLibrary::~FilesystemMusicLibrary()
 {
-	m_Destroy = true;
+    // a running request uses the members that are destroyed before the queue
+    m_Requests.shutdown();
+
+    {
+        std::lock_guard<std::mutex> lock(m_MaintenanceMutex);
+        m_Destroy = true;
+    }
+    m_MaintenanceCondition.notify_all();
+    m_MaintenanceThread.join();
+
 	cancelScanThread();
+    stopWatching();
 }
 
 void FilesystemMusicLibrary::cancelScanThread()
@@ -72,51 +110,59 @@ uint32_t FilesystemMusicLibrary::getAlbumCount()
     return m_Db.getAlbumCount();
 }
 
-void FilesystemMusicLibrary::getTrack(const std::string& id, Track& track)
+void FilesystemMusicLibrary::getTrack(const ItemId& id, Track& track)
 {
     if (!m_Db.getTrack(id, track))
     {
-        throw std::logic_error("Failed to get track from db (id:" + id + ")");
+        throw std::logic_error("Failed to get track from db (id:" + id.toString() + ")");
     }
 }
 
-void FilesystemMusicLibrary::getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber)
+void FilesystemMusicLibrary::getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber)
 {
-    Track track;
-    getTrack(id, track);
-    subscriber.onItem(track);
+    m_Requests.post(RequestQueue::High, &subscriber, [this, id, &subscriber] () {
+        Track track;
+        getTrack(id, track);
+        subscriber.onItem(track);
+    });
 }
 
-void FilesystemMusicLibrary::getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void FilesystemMusicLibrary::getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
     m_Db.getTracksFromAlbum(albumId, subscriber);
 }
 
-void FilesystemMusicLibrary::getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void FilesystemMusicLibrary::getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
-    getTracksFromAlbum(albumId, subscriber);
+    m_Requests.post(RequestQueue::Normal, &subscriber, [this, albumId, &subscriber] () {
+        getTracksFromAlbum(albumId, subscriber);
+    });
 }
 
-void FilesystemMusicLibrary::getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void FilesystemMusicLibrary::getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
     m_Db.getFirstTrackFromAlbum(albumId, subscriber);
 }
 
-void FilesystemMusicLibrary::getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void FilesystemMusicLibrary::getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
-	getFirstTrackFromAlbum(albumId, subscriber);
+    m_Requests.post(RequestQueue::High, &subscriber, [this, albumId, &subscriber] () {
+        getFirstTrackFromAlbum(albumId, subscriber);
+    });
 }
 
-void FilesystemMusicLibrary::getAlbum(const std::string& albumId, Album& album)
+void FilesystemMusicLibrary::getAlbum(const ItemId& albumId, Album& album)
 {
     m_Db.getAlbum(albumId, album);
 }
 
-void FilesystemMusicLibrary::getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber)
+void FilesystemMusicLibrary::getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber)
 {
-	Album album;
-    m_Db.getAlbum(albumId, album);
-    subscriber.onItem(album);
+    m_Requests.post(RequestQueue::High, &subscriber, [this, albumId, &subscriber] () {
+        Album album;
+        m_Db.getAlbum(albumId, album);
+        subscriber.onItem(album);
+    });
 }
 
 void FilesystemMusicLibrary::getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber)
@@ -126,7 +172,9 @@ void FilesystemMusicLibrary::getRandomTracks(uint32_t trackCount, utils::ISubscr
 
 void FilesystemMusicLibrary::getRandomTracksAsync(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber)
 {
-	getRandomTracks(trackCount, subscriber);
+    m_Requests.post(RequestQueue::Normal, &subscriber, [this, trackCount, &subscriber] () {
+        getRandomTracks(trackCount, subscriber);
+    });
 }
 
 void FilesystemMusicLibrary::getRandomAlbum(utils::ISubscriber<const Track&>& subscriber)
@@ -136,8 +184,11 @@ void FilesystemMusicLibrary::getRandomAlbum(utils::ISubscriber<const Track&>& su
 
 void FilesystemMusicLibrary::getRandomAlbumAsync(utils::ISubscriber<const Track&>& subscriber)
 {
-	getRandomAlbum(subscriber);
+    m_Requests.post(RequestQueue::Normal, &subscriber, [this, &subscriber] () {
+        getRandomAlbum(subscriber);
+    });
 }
+
 void FilesystemMusicLibrary::getAlbums(utils::ISubscriber<const Album&>& subscriber)
 {
     m_Db.getAlbums(subscriber);
@@ -145,7 +196,45 @@ void FilesystemMusicLibrary::getAlbums(utils::ISubscriber<const Album&>& subscri
 
 void FilesystemMusicLibrary::getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber)
 {
-    getAlbums(subscriber);
+    getAlbumsAsync(subscriber, AlbumOrder());
+}
+
+void FilesystemMusicLibrary::getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order)
+{
+    uint32_t listing;
+    {
+        std::lock_guard<std::mutex> lock(m_AlbumListingsMutex);
+        listing = ++m_LastAlbumListing;
+        m_AlbumListings[&subscriber] = listing;
+    }
+
+    // the first screenful is loaded right away, the rest of the library
+    // should not delay the smaller requests
+    requestAlbumPage(subscriber, order, Album(), listing, FIRST_ALBUM_PAGE_SIZE, RequestQueue::High);
+}
+
+void FilesystemMusicLibrary::requestAlbumPage(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order, const Album& cursor, uint32_t listing, uint32_t pageSize, RequestQueue::Priority priority)
+{
+    m_Requests.post(priority, &subscriber, [this, &subscriber, order, cursor, listing, pageSize] () {
+        // a new listing for the subscriber replaces the remaining pages
+        if (!isCurrentAlbumListing(subscriber, listing))
+        {
+            return;
+        }
+
+        Album next = cursor;
+        if (m_Db.getAlbumPage(order, next, pageSize, subscriber))
+        {
+            requestAlbumPage(subscriber, order, next, listing, ALBUM_PAGE_SIZE, RequestQueue::Low);
+        }
+    });
+}
+
+bool FilesystemMusicLibrary::isCurrentAlbumListing(utils::ISubscriber<const Album&>& subscriber, uint32_t listing)
+{
+    std::lock_guard<std::mutex> lock(m_AlbumListingsMutex);
+    auto iter = m_AlbumListings.find(&subscriber);
+    return iter != m_AlbumListings.end() && iter->second == listing;
 }
 
 bool FilesystemMusicLibrary::getAlbumArt(const Album& album, AlbumArt& art)
@@ -157,14 +246,18 @@ void FilesystemMusicLibrary::scan(bool startFresh, IScanSubscriber& subscriber)
 {
     string libraryPath = m_Settings.get("MusicLibrary");
 
+    cancelScanThread();
+    stopWatching();
+
     if (startFresh || (m_LibraryPath != libraryPath && !m_LibraryPath.empty()))
     {
         m_Db.clearDatabase();
     }
 
     m_LibraryPath = libraryPath;
-    
-    cancelScanThread();
+
+    // the updates of the watcher wait until the scan is finished
+    startWatching();
     m_ScannerThread = std::thread(&FilesystemMusicLibrary::scannerThread, this, std::ref(subscriber));
 }
 
@@ -178,8 +271,26 @@ void FilesystemMusicLibrary::setSource(const LibrarySource& source)
 	assert(!"FilesystemMusicLibrary::setSource SHOULD NOT HAPPEN");
 }
 
+void FilesystemMusicLibrary::cancelPendingRequests(const void* pSubscriber)
+{
+    {
+        // a page that is being loaded doesn't request the next one
+        std::lock_guard<std::mutex> lock(m_AlbumListingsMutex);
+        m_AlbumListings.erase(pSubscriber);
+    }
+
+    uint32_t cancelled = m_Requests.cancel(pSubscriber);
+    if (cancelled > 0)
+    {
+        log::debug("Cancelled %d pending library requests", cancelled);
+    }
+}
+
 void FilesystemMusicLibrary::scannerThread(IScanSubscriber& subscriber)
 {
+    std::lock_guard<std::mutex> lock(m_UpdateMutex);
+    m_Scanning = true;
+
     try
     {
 		std::vector<std::string> filenames;
@@ -187,7 +298,7 @@ void FilesystemMusicLibrary::scannerThread(IScanSubscriber& subscriber)
         
         {
 			std::lock_guard<std::mutex> lock(m_ScanMutex);
-			m_Scanner.reset(new Scanner(m_Db, subscriber, filenames));
+			m_Scanner.reset(new Scanner(m_Db, subscriber, filenames, m_Settings.getAsInt("ScanThreads", 0)));
 		}
         m_Scanner->performScan(m_LibraryPath);
         
@@ -200,12 +311,181 @@ void FilesystemMusicLibrary::scannerThread(IScanSubscriber& subscriber)
         {
 			m_Db.removeNonExistingAlbums();
 		}
+
+		if (!m_Destroy)
+        {
+			m_Db.updateAlbumMetaData();
+		}
     }
     catch (std::exception& e)
     {
         log::error("Failed to scan library: %s", e.what());
         subscriber.scanFailed();
     }
+
+    m_Db.releaseReadConnection();
+    m_Scanning = false;
+}
+
+void FilesystemMusicLibrary::startWatching()
+{
+#ifdef HAVE_INOTIFY
+    if (m_LibraryPath.empty() || !m_Settings.getAsBool("WatchLibrary", true))
+    {
+        return;
+    }
+
+    m_WatchStopped = false;
+
+    try
+    {
+        m_Watcher.reset(new LibraryWatcher(m_LibraryPath, m_Settings.getAsInt("WatchDebounceTime", 2000),
+                                           [this] (const LibraryWatcher::Changes& changes) { applyLibraryChanges(changes); }));
+    }
+    catch (std::exception& e)
+    {
+        log::warn("Changes to the library will not be detected: %s", e.what());
+    }
+#endif
+}
+
+void FilesystemMusicLibrary::stopWatching()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_ScanMutex);
+        m_WatchStopped = true;
+        if (m_UpdateScanner.get())
+        {
+            m_UpdateScanner->cancel();
+        }
+    }
+
+    m_Watcher.reset();
+}
+
+// Only the paths the watcher reported are checked, so the cost of an update
+// depends on the size of the change and not on the size of the library.
+void FilesystemMusicLibrary::applyLibraryChanges(const LibraryWatcher::Changes& changes)
+{
+    std::lock_guard<std::mutex> lock(m_UpdateMutex);
+
+    try
+    {
+        std::vector<std::string> filenames;
+        m_Settings.getAsVector("AlbumArtFilenames", filenames);
+
+        {
+            std::lock_guard<std::mutex> scanLock(m_ScanMutex);
+            if (m_WatchStopped)
+            {
+                return;
+            }
+
+            m_UpdateScanner.reset(new Scanner(m_Db, m_UpdateSubscriber, filenames, m_Settings.getAsInt("ScanThreads", 0)));
+        }
+
+        removePaths(changes.removedPaths);
+
+        // paths that disappeared again before the update are left out
+        auto exists = [] (const std::string& path) { return fileops::pathExists(path); };
+        std::vector<std::string> directories;
+        std::copy_if(changes.directories.begin(), changes.directories.end(), std::back_inserter(directories), exists);
+        std::vector<std::string> files;
+        std::copy_if(changes.files.begin(), changes.files.end(), std::back_inserter(files), exists);
+
+        log::info("Library changed: %d directories, %d files added or modified, %d paths removed", directories.size(), files.size(), changes.removedPaths.size());
+        m_UpdateScanner->scanChanges(directories, files);
+
+        if (changes.eventsLost)
+        {
+            // the removals are unknown as well
+            m_Db.removeNonExistingFiles();
+        }
+
+        if (!changes.removedPaths.empty() || changes.eventsLost)
+        {
+            m_Db.removeNonExistingAlbums();
+        }
+    }
+    catch (std::exception& e)
+    {
+        log::error("Failed to update the library: %s", e.what());
+    }
+
+    // the watcher thread is idle until the next change
+    m_Db.releaseReadConnection();
+}
+
+void FilesystemMusicLibrary::removePaths(const std::set<std::string>& paths)
+{
+    if (paths.empty())
+    {
+        return;
+    }
+
+    m_Db.beginBatch();
+
+    try
+    {
+        for (auto& path : paths)
+        {
+            // a removed path is either a track or a directory
+            Track track;
+            if (m_Db.getTrackWithPath(path, track))
+            {
+                m_Db.removeTrack(track.id);
+            }
+            else
+            {
+                m_Db.removeDirectory(path);
+            }
+        }
+    }
+    catch (...)
+    {
+        m_Db.rollbackBatch();
+        throw;
+    }
+
+    m_Db.commitBatch();
+}
+
+// Keeps the database file compact and the planner statistics current. The
+// maintenance runs after changes that need it or once per interval, when
+// no scan is busy and the library has been idle for a while.
+void FilesystemMusicLibrary::maintenanceThread(uint32_t intervalInSec, uint32_t timeBudgetInMs)
+{
+    // the first idle period after startup checks the statistics
+    auto lastMaintenance = std::chrono::steady_clock::now() - std::chrono::seconds(intervalInSec);
+
+    std::unique_lock<std::mutex> lock(m_MaintenanceMutex);
+    while (!m_Destroy)
+    {
+        m_MaintenanceCondition.wait_for(lock, MAINTENANCE_CHECK_INTERVAL);
+        if (m_Destroy)
+        {
+            break;
+        }
+
+        bool due = m_Db.isMaintenanceDue() || std::chrono::steady_clock::now() - lastMaintenance >= std::chrono::seconds(intervalInSec);
+        if (!due || m_Scanning || m_Requests.getIdleTime() < MAINTENANCE_IDLE_TIME)
+        {
+            continue;
+        }
+
+        lock.unlock();
+        try
+        {
+            m_Db.performMaintenance(timeBudgetInMs);
+        }
+        catch (std::exception& e)
+        {
+            log::error("Database maintenance failed: %s", e.what());
+        }
+        lock.lock();
+
+        lastMaintenance = std::chrono::steady_clock::now();
+    }
 }
 
 }
@@ -21,10 +21,17 @@
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <map>
+#include <set>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
 
 #include "utils/types.h"
 #include "musicdb.h"
+#include "requestqueue.h"
 #include "musiclibrary.h"
+#include "librarywatcher.h"
 
 namespace Gejengel
 {
@@ -45,20 +52,21 @@ public:
     uint32_t getTrackCount();
     uint32_t getAlbumCount();
 
-    void getTrack(const std::string& id, Track& track);
-    void getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber);
+    void getTrack(const ItemId& id, Track& track);
+    void getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber);
 
-    void getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
-    void getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
 
-    void getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
-    void getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
 
-    void getAlbum(const std::string& albumId, Album& album);
-    void getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber);
+    void getAlbum(const ItemId& albumId, Album& album);
+    void getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber);
 
     void getAlbums(utils::ISubscriber<const Album&>& subscriber);
     void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber);
+    void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order);
 
     void getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber);
     void getRandomTracksAsync(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber);
@@ -73,16 +81,42 @@ public:
 
     void setSource(const LibrarySource& source);
 
+protected:
+    void cancelPendingRequests(const void* pSubscriber);
+
 private:
     void cancelScanThread();
     void scannerThread(IScanSubscriber& subscriber);
+    void startWatching();
+    void stopWatching();
+    void applyLibraryChanges(const LibraryWatcher::Changes& changes);
+    void removePaths(const std::set<std::string>& paths);
+    void requestAlbumPage(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order, const Album& cursor, uint32_t listing, uint32_t pageSize, RequestQueue::Priority priority);
+    bool isCurrentAlbumListing(utils::ISubscriber<const Album&>& subscriber, uint32_t listing);
+    void maintenanceThread(uint32_t intervalInSec, uint32_t timeBudgetInMs);
 
     MusicDb                         m_Db;
+    RequestQueue                    m_Requests;
+    // the current album listing per subscriber, the listings are numbered
+    // across the subscribers so a cancelled listing never becomes current again
+    std::map<const void*, uint32_t> m_AlbumListings;
+    uint32_t                        m_LastAlbumListing;
+    std::mutex                      m_AlbumListingsMutex;
     std::string                     m_LibraryPath;
     std::thread                     m_ScannerThread;
     std::mutex						m_ScanMutex;
     std::unique_ptr<Scanner>	    m_Scanner;
-    bool							m_Destroy;
+    std::atomic<bool>               m_Scanning;
+    // serializes the full scans and the updates of the watcher
+    std::mutex                      m_UpdateMutex;
+    std::unique_ptr<LibraryWatcher> m_Watcher;
+    std::unique_ptr<Scanner>        m_UpdateScanner;
+    IScanSubscriber                 m_UpdateSubscriber;
+    bool                            m_WatchStopped;
+    std::thread                     m_MaintenanceThread;
+    std::mutex                      m_MaintenanceMutex;
+    std::condition_variable         m_MaintenanceCondition;
+    std::atomic<bool>               m_Destroy;
 };
 
 }
@@ -0,0 +1,67 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "idsampler.h"
+
+#include <algorithm>
+
+namespace Gejengel
+{
+
+IdSampler::IdSampler()
+: m_Generation(1)
+, m_LoadedGeneration(0)
+, m_Generator(std::random_device()())
+{
+}
+
+void IdSampler::invalidate()
+{
+    ++m_Generation;
+}
+
+std::vector<uint32_t> IdSampler::sample(uint32_t count, const Loader& loader)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    if (m_LoadedGeneration != m_Generation)
+    {
+        lock.unlock();
+
+        // an invalidate during the load leaves the ids outdated, they are
+        // still used for this sample and reloaded on the next one
+        uint32_t generation = m_Generation;
+        std::vector<uint32_t> ids;
+        loader(ids);
+
+        lock.lock();
+        m_Ids = std::move(ids);
+        m_LoadedGeneration = generation;
+    }
+
+    count = std::min<uint32_t>(count, m_Ids.size());
+
+    // partial Fisher-Yates: the first count entries become the sample, the
+    // order of the cached ids is irrelevant so the shuffle is not undone
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        std::uniform_int_distribution<size_t> distribution(i, m_Ids.size() - 1);
+        std::swap(m_Ids[i], m_Ids[distribution(m_Generator)]);
+    }
+
+    return std::vector<uint32_t>(m_Ids.begin(), m_Ids.begin() + count);
+}
+
+}
@@ -0,0 +1,58 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef ID_SAMPLER_H
+#define ID_SAMPLER_H
+
+#include <vector>
+#include <mutex>
+#include <random>
+#include <atomic>
+#include <functional>
+
+#include "utils/types.h"
+
+namespace Gejengel
+{
+
+// Draws uniform random samples without duplicates from a list of ids.
+// The ids are loaded on first use and reloaded after an invalidate, a
+// sample then costs O(n) in the number of requested ids.
+// The loader runs without holding the lock and invalidate doesn't take it,
+// so a loader that waits for a lock of its own can't deadlock with code that
+// invalidates while holding that lock.
+class IdSampler
+{
+public:
+    typedef std::function<void(std::vector<uint32_t>&)> Loader;
+
+    IdSampler();
+
+    void invalidate();
+    std::vector<uint32_t> sample(uint32_t count, const Loader& loader);
+
+private:
+    std::vector<uint32_t>   m_Ids;
+    // the ids are valid while the loaded generation is the current one
+    std::atomic<uint32_t>   m_Generation;
+    uint32_t                m_LoadedGeneration;
+    std::mt19937            m_Generator;
+    std::mutex              m_Mutex;
+};
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "itemid.h"
+
+#include <deque>
+#include <mutex>
+#include <cassert>
+#include <ostream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "utils/stringoperations.h"
+#include "utils/numericoperations.h"
+
+using namespace utils;
+
+namespace Gejengel
+{
+
+// Prefix of serialized object ids, it keeps them apart from local ids
+static const char OBJECT_ID_PREFIX = '@';
+
+namespace
+{
+    // object ids are never removed, a server only has a limited number of them
+    class ObjectIdTable
+    {
+    public:
+        int64_t intern(const std::string& objectId)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+
+            auto iter = m_Indexes.find(objectId);
+            if (iter != m_Indexes.end())
+            {
+                return iter->second;
+            }
+
+            // the deque keeps the strings at the same address when it grows
+            m_ObjectIds.push_back(objectId);
+            int64_t index = m_ObjectIds.size() - 1;
+            m_Indexes.insert(std::make_pair(objectId, index));
+            return index;
+        }
+
+        const std::string& get(int64_t index)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_ObjectIds.at(index);
+        }
+
+    private:
+        std::deque<std::string>                     m_ObjectIds;
+        std::unordered_map<std::string, int64_t>    m_Indexes;
+        std::mutex                                  m_Mutex;
+    };
+
+    ObjectIdTable& objectIds()
+    {
+        static ObjectIdTable table;
+        return table;
+    }
+}
+
+ItemId ItemId::fromObjectId(const std::string& objectId)
+{
+    if (objectId.empty())
+    {
+        return ItemId();
+    }
+
+    return ItemId(-(objectIds().intern(objectId) + 1));
+}
+
+ItemId ItemId::parse(const std::string& str)
+{
+    if (str.empty())
+    {
+        return ItemId();
+    }
+
+    if (str[0] == OBJECT_ID_PREFIX)
+    {
+        return fromObjectId(str.substr(1));
+    }
+
+    if (str.find_first_not_of("0123456789") == std::string::npos)
+    {
+        return ItemId(stringops::toNumeric<int64_t>(str));
+    }
+
+    return fromObjectId(str);
+}
+
+int64_t ItemId::toInt() const
+{
+    if (!isLocal())
+    {
+        throw std::logic_error("Item id is not a local id: " + toString());
+    }
+
+    return m_Value;
+}
+
+const std::string& ItemId::objectId() const
+{
+    if (!isObjectId())
+    {
+        throw std::logic_error("Item id is not an object id: " + toString());
+    }
+
+    return objectIds().get(-m_Value - 1);
+}
+
+std::string ItemId::toString() const
+{
+    if (isObjectId())
+    {
+        return OBJECT_ID_PREFIX + objectId();
+    }
+
+    return empty() ? std::string() : numericops::toString(m_Value);
+}
+
+std::ostream& operator<<(std::ostream& os, const ItemId& id)
+{
+    return os << id.toString();
+}
+
+}
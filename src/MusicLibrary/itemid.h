@@ -0,0 +1,83 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef ITEM_ID_H
+#define ITEM_ID_H
+
+#include <string>
+#include <iosfwd>
+#include <functional>
+
+#include "utils/types.h"
+
+namespace Gejengel
+{
+
+// Identifies a track or album of a library in 8 bytes. Local libraries use
+// the database row id, the object ids of a UPnP server are interned and
+// referred to by their index in the intern table. Copies and comparisons
+// never touch a string.
+class ItemId
+{
+public:
+    ItemId()
+    : m_Value(0)
+    {
+    }
+
+    explicit ItemId(int64_t localId)
+    : m_Value(localId)
+    {
+    }
+
+    static ItemId fromObjectId(const std::string& objectId);
+
+    // inverse of toString, numeric strings are local ids
+    static ItemId parse(const std::string& str);
+
+    bool empty() const          { return m_Value == 0; }
+    bool isLocal() const        { return m_Value > 0; }
+    bool isObjectId() const     { return m_Value < 0; }
+
+    int64_t toInt() const;
+    const std::string& objectId() const;
+    std::string toString() const;
+
+    bool operator==(const ItemId& other) const  { return m_Value == other.m_Value; }
+    bool operator!=(const ItemId& other) const  { return m_Value != other.m_Value; }
+    bool operator<(const ItemId& other) const   { return m_Value < other.m_Value; }
+
+    size_t hash() const         { return std::hash<int64_t>()(m_Value); }
+
+private:
+    // > 0: local id, < 0: negated index + 1 in the object id table
+    int64_t     m_Value;
+};
+
+std::ostream& operator<<(std::ostream& os, const ItemId& id);
+
+}
+
+namespace std
+{
+    template <>
+    struct hash<Gejengel::ItemId>
+    {
+        size_t operator()(const Gejengel::ItemId& id) const { return id.hash(); }
+    };
+}
+
+#endif
@@ -17,8 +17,7 @@
 #ifndef LIBRARY_ITEM_H
 #define LIBRARY_ITEM_H
 
-#include <string>
-
+#include "itemid.h"
 #include "utils/types.h"
 
 namespace Gejengel
@@ -27,13 +26,13 @@ namespace Gejengel
 class LibraryItem
 {
 public:
-	LibraryItem(const std::string& id = "")
+	LibraryItem(const ItemId& id = ItemId())
     : id(id)
     {}
 
 	virtual ~LibraryItem() {}
 
-    std::string	id;
+    ItemId      id;
 };
 
 }
@@ -0,0 +1,343 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#include "librarywatcher.h"
+
+#include <cerrno>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "utils/fileoperations.h"
+#include "utils/log.h"
+
+using namespace std;
+using namespace utils;
+
+namespace Gejengel
+{
+
+// a steady stream of changes is still applied once in a while
+static const std::chrono::seconds MAX_DEBOUNCE_TIME(30);
+// a library directory that disappeared is checked for again at this interval
+static const std::chrono::seconds LIBRARY_RETRY_INTERVAL(5);
+static const uint32_t WATCH_MASK = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+static const uint32_t LIBRARY_WATCH_MASK = WATCH_MASK | IN_DELETE_SELF | IN_MOVE_SELF;
+static const size_t EVENT_BUFFER_SIZE = 64 * 1024;
+
+// true when one of the parent directories of the path is in the set
+static bool isInDirectories(const std::set<std::string>& directories, const std::string& path)
+{
+    for (auto pos = path.rfind('/'); pos != string::npos && pos > 0; pos = path.rfind('/', pos - 1))
+    {
+        if (directories.find(path.substr(0, pos)) != directories.end())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool LibraryWatcher::Changes::empty() const
+{
+    return directories.empty() && files.empty() && removedPaths.empty() && !eventsLost;
+}
+
+LibraryWatcher::LibraryWatcher(const std::string& libraryPath, uint32_t debounceTimeInMs, const ChangeHandler& handler)
+: m_LibraryPath(libraryPath)
+, m_DebounceTime(debounceTimeInMs)
+, m_Handler(handler)
+, m_Fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+, m_LibraryWatched(false)
+{
+    if (m_Fd < 0)
+    {
+        throw logic_error(string("Failed to initialize inotify: ") + strerror(errno));
+    }
+
+    // written to on destruction to wake up the watcher thread
+    if (pipe(m_StopPipe) != 0)
+    {
+        close(m_Fd);
+        throw logic_error(string("Failed to create library watcher pipe: ") + strerror(errno));
+    }
+
+    m_Thread = std::thread(&LibraryWatcher::watchThread, this);
+}
+
+LibraryWatcher::~LibraryWatcher()
+{
+    char stop = 0;
+    if (write(m_StopPipe[1], &stop, 1) != 1)
+    {
+        log::error("Failed to stop the library watcher: %s", strerror(errno));
+    }
+
+    m_Thread.join();
+
+    close(m_StopPipe[0]);
+    close(m_StopPipe[1]);
+    close(m_Fd);
+}
+
+void LibraryWatcher::watchThread()
+{
+    // adding the watches visits every directory, so it's not done on the
+    // thread that creates the watcher
+    m_LibraryWatched = watchTree(m_LibraryPath);
+    log::debug("Watching %d library directories", m_Watches.size());
+
+    vector<char> buffer(EVENT_BUFFER_SIZE);
+    Changes changes;
+    auto firstEvent = std::chrono::steady_clock::now();
+    auto lastEvent = firstEvent;
+
+    for (;;)
+    {
+        int32_t timeout = -1;
+        if (!changes.empty())
+        {
+            auto now = std::chrono::steady_clock::now();
+            auto remaining = std::min(std::chrono::milliseconds(m_DebounceTime) - (now - lastEvent), MAX_DEBOUNCE_TIME - (now - firstEvent));
+            timeout = std::max<int32_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count());
+        }
+
+        if (!m_LibraryWatched)
+        {
+            // e.g. the disk of the library is not mounted
+            int32_t retryTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(LIBRARY_RETRY_INTERVAL).count();
+            timeout = timeout < 0 ? retryTimeout : std::min(timeout, retryTimeout);
+        }
+
+        pollfd fds[2] = { { m_Fd, POLLIN, 0 }, { m_StopPipe[0], POLLIN, 0 } };
+        int32_t rc = poll(fds, 2, timeout);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            log::error("Library watcher stopped: %s", strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents != 0)
+        {
+            break;
+        }
+
+        if (rc == 0)
+        {
+            if (!m_LibraryWatched && fileops::pathExists(m_LibraryPath))
+            {
+                log::info("The library directory %s is available again", m_LibraryPath);
+                bool wasEmpty = changes.empty();
+                rewatchLibrary(changes);
+                lastEvent = std::chrono::steady_clock::now();
+                if (wasEmpty)
+                {
+                    firstEvent = lastEvent;
+                }
+                continue;
+            }
+
+            auto now = std::chrono::steady_clock::now();
+            if (changes.empty() || (now - lastEvent < std::chrono::milliseconds(m_DebounceTime) && now - firstEvent < MAX_DEBOUNCE_TIME))
+            {
+                continue;
+            }
+
+            Changes ready;
+            std::swap(ready, changes);
+
+            try
+            {
+                m_Handler(ready);
+            }
+            catch (std::exception& e)
+            {
+                log::error("Failed to apply library changes: %s", e.what());
+            }
+            continue;
+        }
+
+        bool wasEmpty = changes.empty();
+
+        ssize_t length;
+        while ((length = read(m_Fd, buffer.data(), buffer.size())) > 0)
+        {
+            processEvents(buffer.data(), static_cast<size_t>(length), changes);
+        }
+
+        lastEvent = std::chrono::steady_clock::now();
+        if (wasEmpty)
+        {
+            firstEvent = lastEvent;
+        }
+    }
+}
+
+bool LibraryWatcher::watchTree(const std::string& path)
+{
+    int32_t wd = inotify_add_watch(m_Fd, path.c_str(), path == m_LibraryPath ? LIBRARY_WATCH_MASK : WATCH_MASK);
+    if (wd < 0)
+    {
+        // e.g. when the max_user_watches limit is reached
+        log::warn("Failed to watch %s: %s", path, strerror(errno));
+        return false;
+    }
+
+    m_Watches[wd] = path;
+
+    try
+    {
+        for (auto& entry : Directory(path))
+        {
+            if (entry.type() == FileSystemEntryType::Directory)
+            {
+                watchTree(entry.path());
+            }
+        }
+    }
+    catch (std::exception& e)
+    {
+        // removed again before it was visited, the event follows
+        log::debug("Failed to watch the subdirectories of %s: %s", path, e.what());
+    }
+
+    return true;
+}
+
+// The watches no longer match the tree when events were lost, so they are
+// all added again and the whole library is checked.
+void LibraryWatcher::rewatchLibrary(Changes& changes)
+{
+    unwatchTree(m_LibraryPath);
+    m_LibraryWatched = watchTree(m_LibraryPath);
+
+    changes = Changes();
+    if (m_LibraryWatched)
+    {
+        changes.directories.insert(m_LibraryPath);
+        changes.eventsLost = true;
+    }
+}
+
+void LibraryWatcher::unwatchTree(const std::string& path)
+{
+    string prefix = path + '/';
+
+    for (auto iter = m_Watches.begin(); iter != m_Watches.end();)
+    {
+        if (iter->second == path || iter->second.compare(0, prefix.size(), prefix) == 0)
+        {
+            inotify_rm_watch(m_Fd, iter->first);
+            iter = m_Watches.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+void LibraryWatcher::processEvents(const char* pBuffer, size_t length, Changes& changes)
+{
+    const char* pEnd = pBuffer + length;
+    while (pBuffer < pEnd)
+    {
+        inotify_event event;
+        memcpy(&event, pBuffer, sizeof(inotify_event));
+        const char* pName = pBuffer + sizeof(inotify_event);
+        pBuffer += sizeof(inotify_event) + event.len;
+
+        if (event.mask & IN_Q_OVERFLOW)
+        {
+            // the unchanged directories are skipped by the scan anyway
+            log::warn("Too many library changes, the whole library will be checked");
+            rewatchLibrary(changes);
+            continue;
+        }
+
+        if (event.mask & IN_IGNORED)
+        {
+            m_Watches.erase(event.wd);
+            continue;
+        }
+
+        auto iter = m_Watches.find(event.wd);
+        if (iter == m_Watches.end())
+        {
+            continue;
+        }
+
+        if ((event.mask & (IN_DELETE_SELF | IN_MOVE_SELF)) && iter->second == m_LibraryPath)
+        {
+            // the tracks of the library are gone until the directory returns
+            log::warn("The library directory %s was removed", m_LibraryPath);
+            unwatchTree(m_LibraryPath);
+            m_LibraryWatched = false;
+            changes = Changes();
+            changes.removedPaths.insert(m_LibraryPath);
+            continue;
+        }
+
+        if (event.len == 0)
+        {
+            continue;
+        }
+
+        string path = fileops::combinePath(iter->second, pName);
+        bool isDirectory = (event.mask & IN_ISDIR) != 0;
+
+        if (event.mask & (IN_DELETE | IN_MOVED_FROM))
+        {
+            if (isDirectory)
+            {
+                unwatchTree(path);
+            }
+
+            // a path that comes back later is removed first and scanned again
+            changes.directories.erase(path);
+            changes.files.erase(path);
+            changes.removedPaths.insert(path);
+        }
+        else if (isDirectory && (event.mask & (IN_CREATE | IN_MOVED_TO)))
+        {
+            watchTree(path);
+            changes.directories.insert(path);
+        }
+        else if (!isDirectory && (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO)))
+        {
+            // a new file is only scanned once it is completely written, the
+            // files of a new directory are scanned with the directory
+            if (!isInDirectories(changes.directories, path))
+            {
+                changes.files.insert(path);
+            }
+        }
+    }
+}
+
+}
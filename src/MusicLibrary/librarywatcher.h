@@ -0,0 +1,78 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef LIBRARY_WATCHER_H
+#define LIBRARY_WATCHER_H
+
+#include <set>
+#include <map>
+#include <string>
+#include <thread>
+#include <functional>
+
+#include "utils/types.h"
+
+namespace Gejengel
+{
+
+// Watches the directory tree of the library with inotify. The changes are
+// collected until no events arrived for the debounce time, so copying an
+// album results in a single update instead of one per file.
+class LibraryWatcher
+{
+public:
+    struct Changes
+    {
+        Changes() : eventsLost(false) {}
+        bool empty() const;
+
+        // created or moved into the library
+        std::set<std::string>   directories;
+        // written or moved into the library
+        std::set<std::string>   files;
+        // deleted or moved out of the library, applied before the additions
+        std::set<std::string>   removedPaths;
+        // events were missed, the whole library has to be checked
+        bool                    eventsLost;
+    };
+
+    // the handler is called on the thread of the watcher
+    typedef std::function<void(const Changes&)> ChangeHandler;
+
+    LibraryWatcher(const std::string& libraryPath, uint32_t debounceTimeInMs, const ChangeHandler& handler);
+    ~LibraryWatcher();
+
+private:
+    void watchThread();
+    bool watchTree(const std::string& path);
+    void rewatchLibrary(Changes& changes);
+    void unwatchTree(const std::string& path);
+    void processEvents(const char* pBuffer, size_t length, Changes& changes);
+
+    std::string                     m_LibraryPath;
+    uint32_t                        m_DebounceTime;
+    ChangeHandler                   m_Handler;
+    int32_t                         m_Fd;
+    int32_t                         m_StopPipe[2];
+    std::map<int32_t, std::string>  m_Watches;
+    bool                            m_LibraryWatched;
+    std::thread                     m_Thread;
+};
+
+}
+
+#endif
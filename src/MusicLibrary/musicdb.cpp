@@ -23,11 +23,16 @@
 #include <sqlite3.h>
 #include <set>
 #include <map>
+#include <chrono>
+#include <atomic>
+#include <thread>
+#include <algorithm>
 
 #include "track.h"
 #include "album.h"
 #include "albumart.h"
 #include "subscribers.h"
+#include "rowcursor.h"
 #include "utils/fileoperations.h"
 #include "utils/stringoperations.h"
 #include "utils/numericoperations.h"
@@ -38,685 +43,1928 @@ using namespace std;
 using namespace utils;
 
 #define BUSY_RETRIES 50
+#define BULK_LOAD_CACHE_SIZE_KB 65536
+#define ANALYSIS_ROW_LIMIT 1000
+#define VACUUM_STEP_PAGES 256
+// the stat calls mostly wait for the disk or the network, not for the cpu
+#define STAT_THREADS 8
+
+// Indexes that none of the statements of a scan rely on, maintaining them while
+// loading an empty database is wasted work. Path lookups use the unique
+// constraints, albumExists needs albumNameIndex and albumArtistIndex, the album
+// art store needs artHashIndex and albumArtIndex and album renames update the
+// search index through albumTracksIndex.
+static const struct
+{
+    const char* name;
+    const char* create;
+} BULK_LOAD_INDEXES[] =
+{
+    { "albumDateIndex",     "CREATE INDEX IF NOT EXISTS albumDateIndex ON albums (DateAdded);" },
+};
 
-namespace Gejengel
+static uint64_t getElapsedMilliseconds(const std::chrono::steady_clock::time_point& start)
 {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
 
-MusicDb::MusicDb(const string& dbFilepath)
-: m_pDb(nullptr)
-, m_pSubscriber(nullptr)
+// checks the existence of the paths on a pool of threads, the result
+// contains a flag for every path
+static vector<uint8_t> findMissingPaths(const vector<string>& paths)
 {
-    utils::trace("Create Music database");
+    vector<uint8_t> missing(paths.size(), 0);
+    std::atomic<size_t> next(0);
+
+    auto worker = [&] () {
+        for (size_t i = next++; i < paths.size(); i = next++)
+        {
+            missing[i] = fileops::pathExists(paths[i]) ? 0 : 1;
+        }
+    };
 
-    if (sqlite3_open(dbFilepath.c_str(), &m_pDb) != SQLITE_OK)
+    size_t threadCount = std::min<size_t>(STAT_THREADS, paths.size() / 64 + 1);
+    vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i)
     {
-        throw logic_error("Failed to open database: " + dbFilepath);
+        threads.push_back(std::thread(worker));
     }
 
-    if (sqlite3_busy_handler(m_pDb, MusicDb::busyCb, nullptr) != SQLITE_OK)
+    worker();
+
+    for (auto& thread : threads)
     {
-        throw logic_error("Failed to set busy handler");
+        thread.join();
     }
 
-    createInitialDatabase();
-
-    utils::trace("Music database loaded");
+    return missing;
 }
 
-MusicDb::~MusicDb()
+namespace Gejengel
 {
-    if (sqlite3_close(m_pDb) != SQLITE_OK)
-    {
-        log::error("Failed to close database");
-    }
-}
 
-void MusicDb::setSubscriber(ILibrarySubscriber& subscriber)
+namespace col
 {
-    m_pSubscriber = &subscriber;
+    // tracks are read from the flattened trackInfo table
+    SQL_COLUMN(TrackId,             int64_t,        "trackInfo.Id");
+    SQL_COLUMN(TrackAlbumId,        int64_t,        "trackInfo.AlbumId");
+    SQL_COLUMN(TrackTitle,          sql::TextRef,   "trackInfo.Title");
+    SQL_COLUMN(TrackComposer,       sql::TextRef,   "trackInfo.Composer");
+    SQL_COLUMN(TrackFilepath,       sql::TextRef,   "trackInfo.Filepath");
+    SQL_COLUMN(TrackYear,           uint32_t,       "trackInfo.Year");
+    SQL_COLUMN(TrackNr,             uint32_t,       "trackInfo.TrackNr");
+    SQL_COLUMN(TrackDiscNr,         uint32_t,       "trackInfo.DiscNr");
+    SQL_COLUMN(TrackDuration,       uint32_t,       "trackInfo.Duration");
+    SQL_COLUMN(TrackBitRate,        uint32_t,       "trackInfo.BitRate");
+    SQL_COLUMN(TrackSampleRate,     uint32_t,       "trackInfo.SampleRate");
+    SQL_COLUMN(TrackChannels,       uint32_t,       "trackInfo.Channels");
+    SQL_COLUMN(TrackFileSize,       uint32_t,       "trackInfo.FileSize");
+    SQL_COLUMN(TrackModifiedTime,   uint32_t,       "trackInfo.ModifiedTime");
+    SQL_COLUMN(TrackArtist,         sql::TextRef,   "trackInfo.Artist");
+    SQL_COLUMN(TrackAlbum,          sql::TextRef,   "trackInfo.Album");
+    SQL_COLUMN(TrackAlbumArtist,    sql::TextRef,   "trackInfo.AlbumArtist");
+    SQL_COLUMN(TrackGenre,          sql::TextRef,   "trackInfo.Genre");
+
+    // the file bookkeeping of the scanner uses the tracks table
+    SQL_COLUMN(FileTrackId,         int64_t,        "tracks.Id");
+    SQL_COLUMN(FileDirectoryId,     int64_t,        "tracks.DirectoryId");
+    SQL_COLUMN(FileName,            sql::TextRef,   "tracks.Filename");
+    SQL_COLUMN(FilePath,            sql::TextRef,   "directories.Path || tracks.Filename");
+    // the full path that was stored before the directory table
+    SQL_COLUMN(FileLegacyPath,      sql::TextRef,   "tracks.Filepath");
+    SQL_COLUMN(FileModifiedTime,    uint32_t,       "tracks.ModifiedTime");
+
+    SQL_COLUMN(AlbumId,             int64_t,        "albums.Id");
+    SQL_COLUMN(AlbumName,           sql::TextRef,   "albums.Name");
+    SQL_COLUMN(AlbumArtist,         sql::TextRef,   "albums.AlbumArtist");
+    SQL_COLUMN(AlbumYear,           uint32_t,       "albums.Year");
+    SQL_COLUMN(AlbumDuration,       uint32_t,       "albums.Duration");
+    SQL_COLUMN(AlbumDateAdded,      uint32_t,       "albums.DateAdded");
+    SQL_COLUMN(AlbumGenre,          sql::TextRef,   "albumGenres.Name");
+
+    SQL_COLUMN(ArtId,               uint32_t,       "albumArt.Id");
+    SQL_COLUMN(ArtData,             sql::BlobRef,   "albumArt.Data");
 }
 
-uint32_t MusicDb::getTrackCount()
+typedef sql::Query<col::TrackId, col::TrackAlbumId, col::TrackTitle, col::TrackComposer, col::TrackFilepath, col::TrackYear,
+                   col::TrackNr, col::TrackDiscNr, col::TrackDuration, col::TrackBitRate, col::TrackSampleRate, col::TrackChannels,
+                   col::TrackFileSize, col::TrackModifiedTime, col::TrackArtist, col::TrackAlbum, col::TrackAlbumArtist, col::TrackGenre> TrackQuery;
+
+// Fills a trackInfo row from the normalized tables, used by the triggers that
+// keep trackInfo in sync with the tracks
+static const char* TRACK_INFO_INSERT =
+    "INSERT INTO trackInfo (Id, AlbumId, Title, Composer, Filepath, Year, TrackNr, DiscNr, AlbumOrder, Duration, BitRate, SampleRate, Channels, FileSize, ModifiedTime, Artist, Album, AlbumArtist, Genre) "
+    "SELECT NEW.Id, NEW.AlbumId, NEW.Title, NEW.Composer, (SELECT Path FROM directories WHERE Id = NEW.DirectoryId) || NEW.Filename, NEW.Year, NEW.TrackNr, NEW.DiscNr, NEW.AlbumOrder, NEW.Duration, NEW.BitRate, NEW.SampleRate, NEW.Channels, NEW.FileSize, NEW.ModifiedTime, "
+    "(SELECT Name FROM artists WHERE Id = NEW.ArtistId), (SELECT Name FROM albums WHERE Id = NEW.AlbumId), (SELECT AlbumArtist FROM albums WHERE Id = NEW.AlbumId), "
+    "(SELECT Name FROM genres WHERE Id = NEW.GenreId); ";
+
+// Selects the track with a path, the directory is looked up by its path as the
+// read connections can't use the directory cache
+#define TRACK_WITH_PATH "FROM tracks INNER JOIN directories ON directories.Id = tracks.DirectoryId WHERE directories.Path = ? AND tracks.Filename = ?"
+
+// The directory keeps its trailing separator so the path of a track is the
+// concatenation of its directory and file name
+static void splitFilepath(const string& filepath, string& directory, string& filename)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    uint32_t count;
-    performQuery(createStatement("SELECT COUNT(Id) FROM tracks;"), countCb, &count);
+    auto pos = filepath.find_last_of("/\\");
+    if (pos == string::npos)
+    {
+        directory.clear();
+        filename = filepath;
+        return;
+    }
 
-    return count;
+    directory = filepath.substr(0, pos + 1);
+    filename = filepath.substr(pos + 1);
 }
 
-uint32_t MusicDb::getAlbumCount()
+// the path of a directory as it is stored in the directory table
+static string getDirectoryPath(const string& path)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    uint32_t count;
-    performQuery(createStatement("SELECT COUNT(Id) FROM albums;"), countCb, &count);
+    if (path.empty() || path.back() == '/' || path.back() == '\\')
+    {
+        return path;
+    }
 
-    return count;
+    return path + '/';
 }
 
-void MusicDb::addTrack(const Track& track)
+// 64-bit FNV-1a, only used to find candidate duplicates of album art
+static int64_t hashAlbumArt(const std::vector<uint8_t>& data)
 {
+    uint64_t hash = 14695981039346656037ULL;
+    for (auto byte : data)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-        sqlite3_stmt* pStmt = createStatement(
-            "INSERT INTO tracks "
-            "(Id, AlbumId, ArtistId, GenreId, Title, Filepath, Composer, Year, TrackNr, DiscNr, AlbumOrder, Duration, BitRate, SampleRate, Channels, FileSize, ModifiedTime) "
-            "VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
-
-        uint32_t albumId = getIdFromTable("albums", track.album);
-        assert(albumId != 0);
-
-        string artistId, genreId;
-        addArtistIfNotExists(track.artist, artistId);
-        addGenreIfNotExists(track.genre, genreId);
-
-        bindValue(pStmt, albumId, 1);
-        bindValue(pStmt, artistId, 2);
-        bindValue(pStmt, genreId, 3);
-        bindValue(pStmt, track.title, 4);
-        bindValue(pStmt, track.filepath, 5);
-        bindValue(pStmt, track.composer, 6);
-        bindValue(pStmt, track.year, 7);
-        bindValue(pStmt, track.trackNr, 8);
-        bindValue(pStmt, track.discNr, 9);
-        bindValue(pStmt, track.discNr * 1000 + track.trackNr, 10);
-        bindValue(pStmt, track.durationInSec, 11);
-        bindValue(pStmt, track.bitrate, 12);
-        bindValue(pStmt, track.sampleRate, 13);
-        bindValue(pStmt, track.channels, 14);
-        bindValue(pStmt, static_cast<uint32_t>(track.fileSize), 15);
-        bindValue(pStmt, track.modifiedTime, 16);
-        performQuery(pStmt);
+        hash ^= byte;
+        hash *= 1099511628211ULL;
     }
 
-    if (m_pSubscriber)
-    {
-        m_pSubscriber->newTrack(track);
-    }
+    return static_cast<int64_t>(hash);
 }
 
-void MusicDb::updateTrack(const Track& track)
+template <typename Row>
+static void getTrackFromRow(const Row& row, Track& track)
 {
-    {
-        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-        sqlite3_stmt* pStmt = createStatement(
-            "UPDATE tracks "
-            "SET AlbumId=?, ArtistId=?, GenreId=?, Title=?, FilePath=?, Composer=?, Year=?, TrackNr=?, DiscNr=?, AlbumOrder=?, Duration=?, BitRate=?, SampleRate=?, Channels=?, FileSize=?, ModifiedTime=? "
-            "WHERE FilePath=?;"
-        );
+    track.id            = ItemId(row.template get<col::TrackId>());
+    track.albumId       = ItemId(row.template get<col::TrackAlbumId>());
+    row.template get<col::TrackTitle>().assignTo(track.title);
+    row.template get<col::TrackComposer>().assignTo(track.composer);
+    row.template get<col::TrackFilepath>().assignTo(track.filepath);
+
+    track.year          = row.template get<col::TrackYear>();
+    track.trackNr       = row.template get<col::TrackNr>();
+    track.discNr        = row.template get<col::TrackDiscNr>();
+    track.durationInSec = row.template get<col::TrackDuration>();
+    track.bitrate       = row.template get<col::TrackBitRate>();
+    track.sampleRate    = row.template get<col::TrackSampleRate>();
+    track.channels      = row.template get<col::TrackChannels>();
+    track.fileSize      = row.template get<col::TrackFileSize>();
+    track.modifiedTime  = row.template get<col::TrackModifiedTime>();
+
+    row.template get<col::TrackArtist>().assignTo(track.artist);
+    row.template get<col::TrackAlbum>().assignTo(track.album);
+    row.template get<col::TrackAlbumArtist>().assignTo(track.albumArtist);
+    row.template get<col::TrackGenre>().assignTo(track.genre);
+}
 
-        string albumId, artistId, genreId;
+template <typename Row>
+static void getAlbumFromRow(const Row& row, Album& album)
+{
+    album.id            = ItemId(row.template get<col::AlbumId>());
+    row.template get<col::AlbumName>().assignTo(album.title);
+    row.template get<col::AlbumArtist>().assignTo(album.artist);
+    album.year          = row.template get<col::AlbumYear>();
+    album.durationInSec = row.template get<col::AlbumDuration>();
+    album.dateAdded     = row.template get<col::AlbumDateAdded>();
+    row.template get<col::AlbumGenre>().assignTo(album.genre);
+}
 
-        getIdFromTable("albums", track.album, albumId);
-        assert(!albumId.empty());
-        addArtistIfNotExists(track.artist, artistId);
-        addGenreIfNotExists(track.genre, genreId);
+template <typename Query, typename Func>
+uint32_t MusicDb::forEachRow(sqlite3_stmt* pStmt, Func func)
+{
+    return performQuery(pStmt, &Query::template rowCallback<Func>, &func);
+}
 
-        bindValue(pStmt, albumId, 1);
-        bindValue(pStmt, artistId, 2);
-        bindValue(pStmt, genreId, 3);
-        bindValue(pStmt, track.title, 4);
-        bindValue(pStmt, track.filepath, 5);
-        bindValue(pStmt, track.composer, 6);
-        bindValue(pStmt, track.year, 7);
-        bindValue(pStmt, track.trackNr, 8);
-        bindValue(pStmt, track.discNr, 9);
-        bindValue(pStmt, track.discNr * 1000 + track.trackNr, 10);
-        bindValue(pStmt, track.durationInSec, 11);
-        bindValue(pStmt, track.bitrate, 12);
-        bindValue(pStmt, track.sampleRate, 13);
-        bindValue(pStmt, track.channels, 14);
-        bindValue(pStmt, track.fileSize, 15);
-        bindValue(pStmt, track.modifiedTime, 16);
-        bindValue(pStmt, track.filepath, 17);
+// Gives access to a connection for read queries: the read-only connection
+// of the calling thread if there is one, otherwise the writer connection,
+// which is then locked for the lifetime of the object.
+// The thread that has a batch open always reads from the writer connection,
+// the read connections can't see its uncommitted changes.
+class MusicDb::ReadConnection
+{
+public:
+    ReadConnection(MusicDb& db)
+    : m_pDb(nullptr)
+    {
+        if (db.m_BatchThread != std::this_thread::get_id())
+        {
+            m_pDb = db.getReadConnection();
+        }
 
-        performQuery(pStmt);
+        if (m_pDb == nullptr)
+        {
+            m_Lock = std::unique_lock<std::recursive_mutex>(db.m_DbMutex);
+            m_pDb = db.m_pDb;
+        }
     }
 
-    if (m_pSubscriber)
+    operator sqlite3*() const
     {
-        m_pSubscriber->updatedTrack(track);
+        return m_pDb;
     }
-}
 
-void MusicDb::addAlbum(Album& album, AlbumArt& art)
+private:
+    std::unique_lock<std::recursive_mutex>  m_Lock;
+    sqlite3*                                m_pDb;
+};
+
+// Applies the statements executed during its lifetime atomically, changes are
+// rolled back unless release is called. Savepoints nest, so this can be used
+// regardless of an active batch.
+class MusicDb::Savepoint
 {
+public:
+    Savepoint(MusicDb& db, const std::string& name)
+    : m_Db(db)
+    , m_Name(name)
+    , m_Lock(db.m_DbMutex)
+    , m_Released(false)
     {
-        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-        if (album.title.empty()) return;
-
-		sqlite3_stmt* pStmt = createStatement(
-			"INSERT INTO albums "
-			"(Id, Name, AlbumArtist, Year, Duration, DiscCount, DateAdded, CoverImage, GenreId) "
-			"VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?);");
-
-		string genreId;
-		addGenreIfNotExists(album.genre, genreId);
-
-		bindValue(pStmt, album.title, 1);
-		bindValue(pStmt, album.artist, 2);
-		bindValue(pStmt, album.year, 3);
-		bindValue(pStmt, album.durationInSec, 4);
-		bindValue(pStmt, 0, 5);
-		bindValue(pStmt, album.dateAdded, 6);
-		art.getData().empty() ? bindValue(pStmt, "NULL", 7) : bindValue(pStmt, &(art.getData()[0]), art.getData().size(), 7);
-		bindValue(pStmt, genreId, 8);
+        m_Db.performQuery(m_Db.createStatement("SAVEPOINT " + m_Name + ";"));
+    }
 
-		performQuery(pStmt);
+    ~Savepoint()
+    {
+        if (m_Released)
+        {
+            return;
+        }
 
-        getIdFromTable("albums", album.title, album.id);
+        try
+        {
+            m_Db.performQuery(m_Db.createStatement("ROLLBACK TO " + m_Name + ";"));
+            m_Db.performQuery(m_Db.createStatement("RELEASE " + m_Name + ";"));
+        }
+        catch (std::exception& e)
+        {
+            log::error("Failed to roll back savepoint %s: %s", m_Name, e.what());
+        }
     }
 
-    if (m_pSubscriber)
+    void release()
     {
-        m_pSubscriber->newAlbum(album);
+        m_Db.performQuery(m_Db.createStatement("RELEASE " + m_Name + ";"));
+        m_Released = true;
     }
-}
 
-void MusicDb::updateAlbum(const Album& album)
+private:
+    MusicDb&                                m_Db;
+    std::string                             m_Name;
+    std::lock_guard<std::recursive_mutex>   m_Lock;
+    bool                                    m_Released;
+};
+
+MusicDb::MusicDb(const string& dbFilepath, uint32_t maxReadConnections)
+: m_DbFilepath(dbFilepath)
+, m_pDb(nullptr)
+, m_pSubscriber(nullptr)
+, m_BatchActive(false)
+, m_MaxReadConnections(maxReadConnections)
+, m_ExtraReadConnections(0)
+, m_BulkLoadActive(false)
+, m_MaintenanceDue(false)
+, m_SynchronousMode(0)
+, m_CacheSize(0)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement(
-        "UPDATE albums "
-        "SET Name=?, AlbumArtist=?, Year=?, Duration=?, GenreId=?"
-        "WHERE Id=?;"
-    );
+    utils::trace("Create Music database");
 
-    string genreId;
-    addGenreIfNotExists(album.genre, genreId);
+    m_pDb = openConnection(SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
 
-    bindValue(pStmt, album.title, 1);
-    bindValue(pStmt, album.artist, 2);
-    bindValue(pStmt, album.year, 3);
-    bindValue(pStmt, album.durationInSec, 4);
-    bindValue(pStmt, genreId, 5);
-    bindValue(pStmt, album.id, 6);
+    // the vacuum mode can only be chosen before the first table is created
+    uint32_t tableCount = 0;
+    performQuery(createStatement("SELECT COUNT(*) FROM sqlite_master;"), countCb, &tableCount);
+    if (tableCount == 0)
+    {
+        performQuery(createStatement("PRAGMA auto_vacuum=INCREMENTAL;"));
+    }
 
-    performQuery(pStmt);
+    // the read connections can't share an in memory database
+    if (m_DbFilepath.empty() || m_DbFilepath == ":memory:")
+    {
+        m_MaxReadConnections = 0;
+    }
 
-    if (m_pSubscriber)
+    if (m_MaxReadConnections > 0)
     {
-        m_pSubscriber->updatedAlbum(album);
+        performQuery(createStatement("PRAGMA journal_mode=WAL;"));
     }
+
+    migrateSchema();
+    loadIdCaches();
+
+    utils::trace("Music database loaded");
 }
 
-void MusicDb::addArtistIfNotExists(const string& name, string& id)
+MusicDb::~MusicDb()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    if (name.empty()) return;
+    if (m_BatchActive)
+    {
+        try
+        {
+            commitBatch();
+        }
+        catch (std::exception& e)
+        {
+            log::error("Failed to commit pending database changes: %s", e.what());
+        }
+    }
+
+    if (m_BulkLoadActive)
+    {
+        try
+        {
+            endBulkLoad();
+        }
+        catch (std::exception& e)
+        {
+            log::error("Failed to finish bulk load: %s", e.what());
+        }
+    }
 
-    getIdFromTable("artists", name, id);
+    StatementCache::Stats stats = m_Statements.getStats();
+    log::debug("Statement cache: %d hits, %d misses, %d statements prepared", stats.hits, stats.misses, stats.prepared);
 
-    if (id.empty())
+    if (m_Profiler.isEnabled())
     {
-        sqlite3_stmt* pStmt = createStatement("INSERT INTO artists (Id, Name) VALUES (NULL, ?);");
-        bindValue(pStmt, name, 1);
-        performQuery(pStmt);
+        log::info("Query profile:\n%s", m_Profiler.dump());
+    }
 
-        getIdFromTable("artists", name, id);
-        assert(!id.empty());
+    for (auto& connection : m_ReadConnections)
+    {
+        closeConnection(connection.second);
     }
+
+    closeConnection(m_pDb);
 }
 
-void MusicDb::addGenreIfNotExists(const string& name, string& id)
+sqlite3* MusicDb::openConnection(int32_t flags)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    if (name.empty()) return;
-
-    getIdFromTable("genres", name, id);
-
-    if (id.empty())
+    sqlite3* pDb = nullptr;
+    if (sqlite3_open_v2(m_DbFilepath.c_str(), &pDb, flags, nullptr) != SQLITE_OK)
     {
-        sqlite3_stmt* pStmt = createStatement("INSERT INTO genres (Id, Name) VALUES (NULL, ?);");
-        bindValue(pStmt, name, 1);
-        performQuery(pStmt);
+        string error = pDb ? sqlite3_errmsg(pDb) : "out of memory";
+        sqlite3_close(pDb);
+        throw logic_error("Failed to open database: " + m_DbFilepath + " (" + error + ")");
+    }
 
-        getIdFromTable("genres", name, id);
-        assert(!id.empty());
+    if (sqlite3_busy_handler(pDb, MusicDb::busyCb, nullptr) != SQLITE_OK)
+    {
+        sqlite3_close(pDb);
+        throw logic_error("Failed to set busy handler");
     }
-}
 
+    m_Profiler.attach(pDb);
+    return pDb;
+}
 
-bool MusicDb::trackExists(const string& filepath)
+void MusicDb::closeConnection(sqlite3* pDb)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement("SELECT Id FROM tracks WHERE tracks.Filepath = ?;");
-    if (sqlite3_bind_text(pStmt, 1, filepath.c_str(), filepath.size(), SQLITE_STATIC) != SQLITE_OK )
+    m_Profiler.detach(pDb);
+    m_Statements.clear(pDb);
+    if (sqlite3_close(pDb) != SQLITE_OK)
     {
-        throw logic_error(string("Failed to bind value: ") + sqlite3_errmsg(m_pDb));
+        log::error("Failed to close database");
     }
-
-    return performQuery(pStmt) == 1;
 }
 
-MusicDb::TrackStatus MusicDb::getTrackStatus(const std::string& filepath, uint32_t modifiedTime)
+sqlite3* MusicDb::getReadConnection()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement("SELECT ModifiedTime FROM tracks WHERE tracks.Filepath = ?;");
-    if (sqlite3_bind_text(pStmt, 1, filepath.c_str(), filepath.size(), SQLITE_STATIC) != SQLITE_OK )
+    if (m_MaxReadConnections == 0)
     {
-        throw logic_error(string("Failed to bind value: ") + sqlite3_errmsg(m_pDb));
+        return nullptr;
     }
 
-    uint32_t dbModifiedTime;
-    int32_t numTracks = performQuery(pStmt, getTrackModificationTimeCb, &dbModifiedTime);
-    assert (numTracks <= 1);
+    std::lock_guard<std::mutex> lock(m_ReadConnectionsMutex);
+    auto iter = m_ReadConnections.find(std::this_thread::get_id());
+    if (iter != m_ReadConnections.end())
+    {
+        return iter->second;
+    }
 
-    if (numTracks == 0)
+    if (m_ReadConnections.size() >= m_MaxReadConnections + m_ExtraReadConnections)
     {
-        return DoesntExist;
+        return nullptr;
     }
-    else if (dbModifiedTime < modifiedTime)
+
+    try
     {
-        return NeedsUpdate;
+        sqlite3* pDb = openConnection(SQLITE_OPEN_READONLY);
+        m_ReadConnections[std::this_thread::get_id()] = pDb;
+        log::debug("Opened read connection %d", m_ReadConnections.size());
+        return pDb;
     }
-    else
+    catch (std::exception& e)
     {
-        return UpToDate;
+        log::warn("Failed to open read connection, using the writer: %s", e.what());
+        m_MaxReadConnections = std::min<uint32_t>(m_MaxReadConnections, m_ReadConnections.size());
+        m_ExtraReadConnections = 0;
+        return nullptr;
     }
 }
 
-void MusicDb::albumExists(const string& name, std::string& id)
+void MusicDb::releaseReadConnection()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    if (name.empty()) return;
-
-    getIdFromTable("albums", name, id);
+    std::lock_guard<std::mutex> lock(m_ReadConnectionsMutex);
+    auto iter = m_ReadConnections.find(std::this_thread::get_id());
+    if (iter != m_ReadConnections.end())
+    {
+        closeConnection(iter->second);
+        m_ReadConnections.erase(iter);
+    }
 }
 
-bool MusicDb::getTrack(const std::string& id, Track& track)
+void MusicDb::addReadConnections(uint32_t count)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT tracks.Id, tracks.albumId, tracks.Title, tracks.Composer, tracks.Filepath, tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
-        "FROM tracks "
-        "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
-        "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
-        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id "
-        "WHERE tracks.Id = ? ;");
-
-    bindValue(pStmt, id, 1);
-    performQuery(pStmt, getTrackInfoCb, &track);
-
-    return !track.id.empty();
+    std::lock_guard<std::mutex> lock(m_ReadConnectionsMutex);
+    m_ExtraReadConnections += count;
 }
 
-bool MusicDb::getTrackWithPath(const string& filepath, Track& track)
+// the open connections stay until their threads release them
+void MusicDb::removeReadConnections(uint32_t count)
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT tracks.Id, tracks.albumId, tracks.Title, tracks.Composer, tracks.Filepath, tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
-        "FROM tracks "
-        "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
-        "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
-        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id "
-        "WHERE tracks.Filepath = ? ;");
-
-    bindValue(pStmt, filepath, 1);
-    performQuery(pStmt, getTrackInfoCb, &track);
+    std::lock_guard<std::mutex> lock(m_ReadConnectionsMutex);
+    m_ExtraReadConnections -= std::min(count, m_ExtraReadConnections);
+}
 
-    return !track.id.empty();
+void MusicDb::setSubscriber(ILibrarySubscriber& subscriber)
+{
+    m_pSubscriber = &subscriber;
 }
 
-bool MusicDb::getAlbum(const std::string& albumId, Album& album)
+void MusicDb::beginBatch()
 {
     std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    assert(!albumId.empty());
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT albums.Id, albums.Name, albums.AlbumArtist, albums.Year, albums.Duration, albums.DateAdded, genres.Name "
-        "FROM albums "
-        "LEFT OUTER JOIN genres ON albums.GenreId = genres.Id "
-        "WHERE albums.Id = ?;");
+    assert(!m_BatchActive);
 
-    bindValue(pStmt, albumId, 1);
-    performQuery(pStmt, getAlbumCb, &album);
-    return !album.id.empty();
+    performQuery(createStatement("BEGIN TRANSACTION;"));
+    m_BatchActive = true;
+    m_BatchThread = std::this_thread::get_id();
 }
 
-void MusicDb::getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber)
+void MusicDb::commitBatch()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    std::vector<Notification> notifications;
 
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT tracks.Id, tracks.AlbumId, tracks.Title, tracks.Composer, tracks.Filepath, tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
-        "FROM tracks "
-        "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
-        "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
-        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id "
-        "ORDER BY RANDOM() LIMIT ?;");
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        assert(m_BatchActive);
 
-    bindValue(pStmt, trackCount, 1);
-    performQuery(pStmt, getTracksCb, &subscriber);
+        performQuery(createStatement("COMMIT TRANSACTION;"));
+        m_BatchActive = false;
+
+        // the read connections could have reloaded the samplers before the commit
+        m_TrackSampler.invalidate();
+        m_AlbumSampler.invalidate();
+        m_BatchThread = std::thread::id();
+        notifications.swap(m_PendingNotifications);
+    }
+
+    if (m_pSubscriber)
+    {
+        for (auto& notification : notifications)
+        {
+            notification(*m_pSubscriber);
+        }
+    }
 }
 
-void MusicDb::getRandomAlbum(utils::ISubscriber<const Track&>& subscriber)
+void MusicDb::rollbackBatch()
 {
     std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    if (!m_BatchActive)
+    {
+        return;
+    }
 
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT Id "
-        "FROM albums "
-        "ORDER BY RANDOM() LIMIT 1;");
+    m_BatchActive = false;
+    m_BatchThread = std::thread::id();
+    m_PendingNotifications.clear();
 
-    std::string id;
-    performQuery(pStmt, getIdCb, &id);
+    // a failed commit can already have ended the transaction
+    if (sqlite3_get_autocommit(m_pDb) == 0)
+    {
+        performQuery(createStatement("ROLLBACK TRANSACTION;"));
+    }
 
-    getTracksFromAlbum(id, subscriber);
+    // the caches can refer to rows that were rolled back
+    loadIdCaches();
+    m_TrackSampler.invalidate();
+    m_AlbumSampler.invalidate();
 }
 
-void MusicDb::getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+bool MusicDb::isBatchActive()
 {
     std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT tracks.Id, tracks.AlbumId, tracks.Title, tracks.Composer, tracks.Filepath, tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
-        "FROM tracks "
-        "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
-        "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
-        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id "
-        "WHERE albums.Id = ? "
-        "ORDER BY tracks.AlbumOrder LIMIT 1;");
-
-    bindValue(pStmt, albumId, 1);
-    performQuery(pStmt, getTracksCb, &subscriber);
+    return m_BatchActive;
 }
 
-void MusicDb::getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void MusicDb::beginBulkLoad()
 {
     std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT tracks.Id, tracks.AlbumId, tracks.Title, tracks.Composer, tracks.Filepath, tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
-        "FROM tracks "
-        "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
-        "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
-        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id "
-        "WHERE albums.Id = ? "
-        "ORDER BY tracks.AlbumOrder;");
+    assert(!m_BatchActive);
+    assert(!m_BulkLoadActive);
 
-    bindValue(pStmt, albumId, 1);
+    for (auto& index : BULK_LOAD_INDEXES)
+    {
+        performQuery(createStatement(string("DROP INDEX IF EXISTS ") + index.name + ";"));
+    }
 
-    performQuery(pStmt, getTracksCb, &subscriber);
-}
+    // an interrupted bulk load is repaired by scanning the library again
+    m_SynchronousMode = getPragma("synchronous");
+    m_CacheSize = getPragma("cache_size");
+    performQuery(createStatement("PRAGMA synchronous=OFF;"));
+    performQuery(createStatement("PRAGMA cache_size=-" + numericops::toString(BULK_LOAD_CACHE_SIZE_KB) + ";"));
 
-void MusicDb::getAlbums(utils::ISubscriber<const Album&>& subscriber)
-{
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    performQuery(createStatement("SELECT albums.Id, albums.Name, albums.AlbumArtist, albums.Year, albums.Duration, albums.DateAdded, genres.Name "
-                                 "FROM albums "
-                                 "LEFT OUTER JOIN genres ON albums.GenreId = genres.Id;"), getAlbumsCb, &subscriber);
-    subscriber.finalItemReceived();
+    // the read connections keep a wal database open, the writer can't lock it
+    // exclusively, but it doesn't block them in wal mode either
+    if (m_MaxReadConnections == 0)
+    {
+        performQuery(createStatement("PRAGMA locking_mode=EXCLUSIVE;"));
+    }
+
+    m_BulkLoadActive = true;
+    log::debug("Bulk load started");
 }
 
-bool MusicDb::getAlbumArt(const Album& album, AlbumArt& art)
+void MusicDb::endBulkLoad()
 {
     std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement("SELECT CoverImage FROM albums WHERE Id = ?;");
-    bindValue(pStmt, album.id, 1);
-    performQuery(pStmt, getAlbumArtCb, &art.getData());
+    assert(!m_BatchActive);
+    assert(m_BulkLoadActive);
 
-    return !art.getData().empty();
+    auto start = std::chrono::steady_clock::now();
+
+    Savepoint savepoint(*this, "bulkLoad");
+    for (auto& index : BULK_LOAD_INDEXES)
+    {
+        performQuery(createStatement(index.create));
+    }
+    savepoint.release();
+
+    performQuery(createStatement("PRAGMA synchronous=" + numericops::toString(m_SynchronousMode) + ";"));
+    performQuery(createStatement("PRAGMA cache_size=" + numericops::toString(m_CacheSize) + ";"));
+    performQuery(createStatement("PRAGMA locking_mode=NORMAL;"));
+
+    // the exclusive lock is only released on the next access of the database
+    uint32_t count = 0;
+    performQuery(createStatement("SELECT COUNT(*) FROM schemaInfo;"), countCb, &count);
+
+    m_BulkLoadActive = false;
+    m_MaintenanceDue = true;
+    log::debug("Bulk load finished, rebuilding the indexes took %d ms", getElapsedMilliseconds(start));
 }
 
-void MusicDb::setAlbumArt(const std::string& albumId, const std::vector<uint8_t>& data)
+bool MusicDb::isBulkLoadActive()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    sqlite3_stmt* pStmt = createStatement("UPDATE albums SET CoverImage=? WHERE Id=?;");
-    bindValue(pStmt, &data.front(), data.size(), 1);
-    bindValue(pStmt, albumId, 2);
-    performQuery(pStmt);
+    return m_BulkLoadActive;
 }
 
-void MusicDb::removeTrack(const std::string& id)
+void MusicDb::notify(const Notification& notification)
 {
+    if (!m_pSubscriber)
+    {
+        return;
+    }
+
     {
         std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-        sqlite3_stmt* pStmt = createStatement("DELETE from tracks WHERE Id = ?");
-        bindValue(pStmt, id, 1);
-        performQuery(pStmt);
+        if (m_BatchActive)
+        {
+            m_PendingNotifications.push_back(notification);
+            return;
+        }
+    }
+
+    notification(*m_pSubscriber);
+}
+
+uint32_t MusicDb::getTrackCount()
+{
+    ReadConnection db(*this);
+    uint32_t count;
+    performQuery(createStatement(db, "SELECT COUNT(Id) FROM tracks;"), countCb, &count);
+
+    return count;
+}
+
+uint32_t MusicDb::getAlbumCount()
+{
+    ReadConnection db(*this);
+    uint32_t count;
+    performQuery(createStatement(db, "SELECT COUNT(Id) FROM albums;"), countCb, &count);
+
+    return count;
+}
+
+void MusicDb::addTrack(const Track& track)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        Statement pStmt = createStatement(
+            "INSERT INTO tracks "
+            "(Id, AlbumId, ArtistId, GenreId, Title, DirectoryId, Filename, Composer, Year, TrackNr, DiscNr, AlbumOrder, Duration, BitRate, SampleRate, Channels, FileSize, ModifiedTime) "
+            "VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);");
+
+        // albums with the same title are told apart by the id of the track
+        uint32_t albumId = track.albumId.empty() ? getAlbumId(track.album) : static_cast<uint32_t>(track.albumId.toInt());
+        assert(albumId != 0);
+
+        string directory, filename;
+        splitFilepath(track.filepath, directory, filename);
+
+        bindValue(pStmt, albumId, 1);
+        bindId(pStmt, addArtistIfNotExists(track.artist), 2);
+        bindId(pStmt, addGenreIfNotExists(track.genre), 3);
+        bindValue(pStmt, track.title, 4);
+        bindValue(pStmt, addDirectoryIfNotExists(directory), 5);
+        bindText(pStmt, filename, 6);
+        bindValue(pStmt, track.composer, 7);
+        bindValue(pStmt, track.year, 8);
+        bindValue(pStmt, track.trackNr, 9);
+        bindValue(pStmt, track.discNr, 10);
+        bindValue(pStmt, track.discNr * 1000 + track.trackNr, 11);
+        bindValue(pStmt, track.durationInSec, 12);
+        bindValue(pStmt, track.bitrate, 13);
+        bindValue(pStmt, track.sampleRate, 14);
+        bindValue(pStmt, track.channels, 15);
+        bindValue(pStmt, static_cast<uint32_t>(track.fileSize), 16);
+        bindValue(pStmt, track.modifiedTime, 17);
+        performQuery(pStmt);
+        m_TrackSampler.invalidate();
+    }
+
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.newTrack(track); });
+}
+
+void MusicDb::updateTrack(const Track& track)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        Statement pStmt = createStatement(
+            "UPDATE tracks "
+            "SET AlbumId=?, ArtistId=?, GenreId=?, Title=?, Composer=?, Year=?, TrackNr=?, DiscNr=?, AlbumOrder=?, Duration=?, BitRate=?, SampleRate=?, Channels=?, FileSize=?, ModifiedTime=? "
+            "WHERE DirectoryId=? AND Filename=?;"
+        );
+
+        // albums with the same title are told apart by the id of the track
+        uint32_t albumId = track.albumId.empty() ? getAlbumId(track.album) : static_cast<uint32_t>(track.albumId.toInt());
+        assert(albumId != 0);
+
+        string directory, filename;
+        splitFilepath(track.filepath, directory, filename);
+
+        bindValue(pStmt, albumId, 1);
+        bindId(pStmt, addArtistIfNotExists(track.artist), 2);
+        bindId(pStmt, addGenreIfNotExists(track.genre), 3);
+        bindValue(pStmt, track.title, 4);
+        bindValue(pStmt, track.composer, 5);
+        bindValue(pStmt, track.year, 6);
+        bindValue(pStmt, track.trackNr, 7);
+        bindValue(pStmt, track.discNr, 8);
+        bindValue(pStmt, track.discNr * 1000 + track.trackNr, 9);
+        bindValue(pStmt, track.durationInSec, 10);
+        bindValue(pStmt, track.bitrate, 11);
+        bindValue(pStmt, track.sampleRate, 12);
+        bindValue(pStmt, track.channels, 13);
+        bindValue(pStmt, track.fileSize, 14);
+        bindValue(pStmt, track.modifiedTime, 15);
+        bindValue(pStmt, addDirectoryIfNotExists(directory), 16);
+        bindText(pStmt, filename, 17);
+
+        performQuery(pStmt);
+    }
+
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.updatedTrack(track); });
+}
+
+void MusicDb::addAlbum(Album& album, AlbumArt& art)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        if (album.title.empty()) return;
+
+		Statement pStmt = createStatement(
+			"INSERT INTO albums "
+			"(Id, Name, AlbumArtist, Year, Duration, DiscCount, DateAdded, ArtId, GenreId) "
+			"VALUES (NULL, ?, ?, ?, ?, ?, ?, ?, ?);");
+
+		bindValue(pStmt, album.title, 1);
+		bindValue(pStmt, album.artist, 2);
+		bindValue(pStmt, album.year, 3);
+		bindValue(pStmt, album.durationInSec, 4);
+		bindValue(pStmt, album.discCount, 5);
+		bindValue(pStmt, album.dateAdded, 6);
+		bindId(pStmt, storeAlbumArt(art.getData()), 7);
+		bindId(pStmt, addGenreIfNotExists(album.genre), 8);
+
+		performQuery(pStmt);
+
+        uint32_t albumId = static_cast<uint32_t>(sqlite3_last_insert_rowid(m_pDb));
+        m_AlbumIds[album.title] = albumId;
+        m_AlbumNames[albumId] = album.title;
+        m_AlbumSampler.invalidate();
+        album.id = ItemId(albumId);
+    }
+
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.newAlbum(album); });
+}
+
+void MusicDb::updateAlbum(const Album& album)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    Statement pStmt = createStatement(
+        "UPDATE albums "
+        "SET Name=?, AlbumArtist=?, Year=?, Duration=?, DiscCount=?, GenreId=?"
+        "WHERE Id=?;"
+    );
+
+    bindValue(pStmt, album.title, 1);
+    bindValue(pStmt, album.artist, 2);
+    bindValue(pStmt, album.year, 3);
+    bindValue(pStmt, album.durationInSec, 4);
+    bindValue(pStmt, album.discCount, 5);
+    bindId(pStmt, addGenreIfNotExists(album.genre), 6);
+    bindValue(pStmt, album.id, 7);
+
+    performQuery(pStmt);
+
+    uint32_t albumId = static_cast<uint32_t>(album.id.toInt());
+    auto iter = m_AlbumNames.find(albumId);
+    if (iter != m_AlbumNames.end() && iter->second != album.title)
+    {
+        forgetAlbumName(iter->second, albumId);
+        m_AlbumIds[album.title] = albumId;
+        iter->second = album.title;
+    }
+
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.updatedAlbum(album); });
+}
+
+uint32_t MusicDb::addArtistIfNotExists(const string& name)
+{
+    return addNameIfNotExists(m_ArtistIds, "INSERT INTO artists (Id, Name) VALUES (NULL, ?);", name);
+}
+
+uint32_t MusicDb::addGenreIfNotExists(const string& name)
+{
+    return addNameIfNotExists(m_GenreIds, "INSERT INTO genres (Id, Name) VALUES (NULL, ?);", name);
+}
+
+uint32_t MusicDb::addNameIfNotExists(IdMap& ids, const char* insertQuery, const std::string& name)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    if (name.empty()) return 0;
+
+    auto iter = ids.find(name);
+    if (iter != ids.end())
+    {
+        return iter->second;
+    }
+
+    Statement pStmt = createStatement(insertQuery);
+    bindValue(pStmt, name, 1);
+    performQuery(pStmt);
+
+    uint32_t id = static_cast<uint32_t>(sqlite3_last_insert_rowid(m_pDb));
+    ids.insert(std::make_pair(name, id));
+    return id;
+}
+
+// unlike the names an empty directory is valid, it holds the relative paths
+uint32_t MusicDb::addDirectoryIfNotExists(const std::string& path)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+
+    auto iter = m_DirectoryIds.find(path);
+    if (iter != m_DirectoryIds.end())
+    {
+        return iter->second;
+    }
+
+    Statement pStmt = createStatement("INSERT INTO directories (Id, Path) VALUES (NULL, ?);");
+    bindText(pStmt, path, 1);
+    performQuery(pStmt);
+
+    uint32_t id = static_cast<uint32_t>(sqlite3_last_insert_rowid(m_pDb));
+    m_DirectoryIds.insert(std::make_pair(path, id));
+    return id;
+}
+
+uint32_t MusicDb::getAlbumId(const std::string& name)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+
+    auto iter = m_AlbumIds.find(name);
+    return iter == m_AlbumIds.end() ? 0 : iter->second;
+}
+
+void MusicDb::loadIdCaches()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+
+    m_ArtistIds.clear();
+    m_GenreIds.clear();
+    m_AlbumIds.clear();
+    m_AlbumNames.clear();
+    m_DirectoryIds.clear();
+
+    performQuery(createStatement("SELECT Id, Name FROM artists;"), getNameIdsCb, &m_ArtistIds);
+    performQuery(createStatement("SELECT Id, Name FROM genres;"), getNameIdsCb, &m_GenreIds);
+    performQuery(createStatement("SELECT Id, Name FROM albums;"), getNameIdsCb, &m_AlbumIds);
+    performQuery(createStatement("SELECT Id, Path FROM directories;"), getNameIdsCb, &m_DirectoryIds);
+
+    for (auto& album : m_AlbumIds)
+    {
+        m_AlbumNames[album.second] = album.first;
+    }
+
+    log::debug("Id caches loaded: %d artists, %d genres, %d albums, %d directories", m_ArtistIds.size(), m_GenreIds.size(), m_AlbumIds.size(), m_DirectoryIds.size());
+}
+
+bool MusicDb::trackExists(const string& filepath)
+{
+    string directory, filename;
+    splitFilepath(filepath, directory, filename);
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, "SELECT tracks.Id " TRACK_WITH_PATH ";");
+    bindText(pStmt, directory, 1);
+    bindText(pStmt, filename, 2);
+
+    return performQuery(pStmt) == 1;
+}
+
+MusicDb::TrackStatus MusicDb::getTrackStatus(const std::string& filepath, uint32_t modifiedTime)
+{
+    typedef sql::Query<col::FileModifiedTime> StatusQuery;
+    static const string query = StatusQuery::text(TRACK_WITH_PATH ";");
+
+    string directory, filename;
+    splitFilepath(filepath, directory, filename);
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, query);
+    bindText(pStmt, directory, 1);
+    bindText(pStmt, filename, 2);
+
+    uint32_t dbModifiedTime = 0;
+    int32_t numTracks = forEachRow<StatusQuery>(pStmt, [&] (const StatusQuery::RowType& row) {
+        dbModifiedTime = row.get<col::FileModifiedTime>();
+    });
+    assert (numTracks <= 1);
+
+    if (numTracks == 0)
+    {
+        return DoesntExist;
+    }
+    else if (dbModifiedTime < modifiedTime)
+    {
+        return NeedsUpdate;
+    }
+    else
+    {
+        return UpToDate;
+    }
+}
+
+void MusicDb::albumExists(const string& name, ItemId& id)
+{
+    if (name.empty()) return;
+
+    uint32_t albumId = getAlbumId(name);
+    if (albumId != 0)
+    {
+        id = ItemId(albumId);
+    }
+}
+
+// Without an album artist any album with the title matches, the albums of
+// tracks without one get their artist from the tracks
+void MusicDb::albumExists(const string& name, const string& albumArtist, ItemId& id)
+{
+    if (albumArtist.empty())
+    {
+        albumExists(name, id);
+        return;
+    }
+
+    if (name.empty()) return;
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, "SELECT Id FROM albums WHERE Name = ? AND AlbumArtist = ? LIMIT 1;");
+    bindValue(pStmt, name, 1);
+    bindValue(pStmt, albumArtist, 2);
+
+    vector<ItemId> ids;
+    performQuery(pStmt, getIdsCb, &ids);
+    if (!ids.empty())
+    {
+        id = ids.front();
+    }
+}
+
+bool MusicDb::getTrack(const ItemId& id, Track& track)
+{
+    static const string query = TrackQuery::text("FROM trackInfo WHERE trackInfo.Id = ?;");
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, query);
+    bindValue(pStmt, id, 1);
+
+    return forEachRow<TrackQuery>(pStmt, [&] (const TrackQuery::RowType& row) {
+        getTrackFromRow(row, track);
+    }) > 0;
+}
+
+bool MusicDb::getTrackWithPath(const string& filepath, Track& track)
+{
+    static const string query = TrackQuery::text("FROM trackInfo WHERE trackInfo.Id = (SELECT tracks.Id " TRACK_WITH_PATH ");");
+
+    string directory, filename;
+    splitFilepath(filepath, directory, filename);
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, query);
+    bindText(pStmt, directory, 1);
+    bindText(pStmt, filename, 2);
+
+    return forEachRow<TrackQuery>(pStmt, [&] (const TrackQuery::RowType& row) {
+        getTrackFromRow(row, track);
+    }) > 0;
+}
+
+bool MusicDb::getAlbum(const ItemId& albumId, Album& album)
+{
+    ReadConnection db(*this);
+    assert(!albumId.empty());
+    Statement pStmt = createStatement(db,
+        "SELECT albums.Id, albums.Name, albums.AlbumArtist, albums.Year, albums.Duration, albums.DateAdded, genres.Name, albums.DiscCount "
+        "FROM albums "
+        "LEFT OUTER JOIN genres ON albums.GenreId = genres.Id "
+        "WHERE albums.Id = ?;");
+
+    bindValue(pStmt, albumId, 1);
+    performQuery(pStmt, getAlbumCb, &album);
+    return !album.id.empty();
+}
+
+void MusicDb::getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber)
+{
+    vector<uint32_t> ids = m_TrackSampler.sample(trackCount, [this] (vector<uint32_t>& ids) {
+        ReadConnection db(*this);
+        performQuery(createStatement(db, "SELECT Id FROM tracks;"), getIntIdsCb, &ids);
+    });
+
+    for (auto id : ids)
+    {
+        // a track that was removed after the sampler was loaded is skipped
+        Track track;
+        if (getTrack(ItemId(id), track))
+        {
+            subscriber.onItem(track);
+        }
+    }
+}
+
+void MusicDb::getRandomAlbum(utils::ISubscriber<const Track&>& subscriber)
+{
+    vector<uint32_t> ids = m_AlbumSampler.sample(1, [this] (vector<uint32_t>& ids) {
+        ReadConnection db(*this);
+        performQuery(createStatement(db, "SELECT Id FROM albums;"), getIntIdsCb, &ids);
+    });
+
+    if (!ids.empty())
+    {
+        getTracksFromAlbum(ItemId(ids.front()), subscriber);
+    }
+}
+
+void MusicDb::getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
+{
+    static const string query = TrackQuery::text("FROM trackInfo WHERE trackInfo.AlbumId = ? ORDER BY trackInfo.AlbumOrder LIMIT 1;");
+
+    Track track;
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, query);
+    bindValue(pStmt, albumId, 1);
+    forEachRow<TrackQuery>(pStmt, [&] (const TrackQuery::RowType& row) {
+        getTrackFromRow(row, track);
+        subscriber.onItem(track);
+    });
+}
+
+void MusicDb::getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
+{
+    static const string query = TrackQuery::text("FROM trackInfo WHERE trackInfo.AlbumId = ? ORDER BY trackInfo.AlbumOrder;");
+
+    // the track is reused for every row so its strings keep their capacity
+    Track track;
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, query);
+    bindValue(pStmt, albumId, 1);
+    forEachRow<TrackQuery>(pStmt, [&] (const TrackQuery::RowType& row) {
+        getTrackFromRow(row, track);
+        subscriber.onItem(track);
+    });
+}
+
+void MusicDb::getAlbums(utils::ISubscriber<const Album&>& subscriber)
+{
+    typedef sql::Query<col::AlbumId, col::AlbumName, col::AlbumArtist, col::AlbumYear, col::AlbumDuration, col::AlbumDateAdded, col::AlbumGenre> AlbumsQuery;
+    static const string query = AlbumsQuery::text("FROM albums LEFT OUTER JOIN genres AS albumGenres ON albums.GenreId = albumGenres.Id;");
+
+    // the album is reused for every row so its strings keep their capacity
+    Album album;
+
+    ReadConnection db(*this);
+    forEachRow<AlbumsQuery>(createStatement(db, query), [&] (const AlbumsQuery::RowType& row) {
+        getAlbumFromRow(row, album);
+        subscriber.onItem(album);
+    });
+    subscriber.finalItemReceived();
+}
+
+bool MusicDb::getAlbumPage(const AlbumOrder& order, Album& cursor, uint32_t pageSize, utils::ISubscriber<const Album&>& subscriber)
+{
+    typedef sql::Query<col::AlbumId, col::AlbumName, col::AlbumArtist, col::AlbumYear, col::AlbumDuration, col::AlbumDateAdded, col::AlbumGenre> AlbumsQuery;
+    assert(pageSize > 0);
+
+    // the sort keys match the album indexes, the id makes the order unique
+    static const char* keys[] = { "albums.Name", "IFNULL(albums.AlbumArtist, '')", "albums.DateAdded" };
+    string key = keys[order.column];
+    string direction = order.descending ? " DESC" : "";
+    string compare = order.descending ? " <" : " >";
+
+    // the row after the cursor, spelled out so the index is also used for
+    // the artist expression
+    string clauses = "FROM albums LEFT OUTER JOIN genres AS albumGenres ON albums.GenreId = albumGenres.Id ";
+    if (!cursor.id.empty())
+    {
+        clauses += "WHERE " + key + compare + "= ? AND (" + key + compare + " ? OR albums.Id" + compare + " ?) ";
+    }
+    clauses += "ORDER BY " + key + direction + ", albums.Id" + direction + " LIMIT ?;";
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, AlbumsQuery::text(clauses));
+
+    int32_t index = 1;
+    if (!cursor.id.empty())
+    {
+        for (int32_t i = 0; i < 2; ++i)
+        {
+            switch (order.column)
+            {
+            case AlbumOrder::Title:     bindText(pStmt, cursor.title, index++); break;
+            case AlbumOrder::Artist:    bindText(pStmt, cursor.artist, index++); break;
+            case AlbumOrder::DateAdded: bindValue(pStmt, static_cast<uint32_t>(cursor.dateAdded), index++); break;
+            }
+        }
+
+        bindValue(pStmt, cursor.id, index++);
+    }
+    bindValue(pStmt, pageSize, index);
+
+    // the cursor strings are bound to the statement, they can't be reused for the rows
+    Album album;
+    uint32_t count = forEachRow<AlbumsQuery>(pStmt, [&] (const AlbumsQuery::RowType& row) {
+        getAlbumFromRow(row, album);
+        subscriber.onItem(album);
+    });
+
+    if (count > 0)
+    {
+        cursor = album;
+    }
+
+    if (count < pageSize)
+    {
+        subscriber.finalItemReceived();
+        return false;
+    }
+
+    return true;
+}
+
+bool MusicDb::getAlbumArt(const Album& album, AlbumArt& art)
+{
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, "SELECT albumArt.Data FROM albums INNER JOIN albumArt ON albums.ArtId = albumArt.Id WHERE albums.Id = ?;");
+    bindValue(pStmt, album.id, 1);
+    performQuery(pStmt, getAlbumArtCb, &art.getData());
+
+    return !art.getData().empty();
+}
+
+void MusicDb::setAlbumArt(const ItemId& albumId, const std::vector<uint8_t>& data)
+{
+    Savepoint savepoint(*this, "setAlbumArt");
+    Statement pStmt = createStatement("UPDATE albums SET ArtId=? WHERE Id=?;");
+    bindId(pStmt, storeAlbumArt(data), 1);
+    bindValue(pStmt, albumId, 2);
+    performQuery(pStmt);
+
+    removeUnusedAlbumArt();
+    savepoint.release();
+}
+
+uint32_t MusicDb::storeAlbumArt(const std::vector<uint8_t>& data)
+{
+    typedef sql::Query<col::ArtId, col::ArtData> ArtQuery;
+    static const string query = ArtQuery::text("FROM albumArt WHERE Hash = ?;");
+
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    if (data.empty()) return 0;
+
+    int64_t hash = hashAlbumArt(data);
+
+    // a hash match is only a candidate, the data decides
+    uint32_t artId = 0;
+    Statement pStmt = createStatement(query);
+    bindInt64(pStmt, hash, 1);
+    forEachRow<ArtQuery>(pStmt, [&] (const ArtQuery::RowType& row) {
+        if (artId == 0 && row.get<col::ArtData>().equals(&data.front(), data.size()))
+        {
+            artId = row.get<col::ArtId>();
+        }
+    });
+
+    if (artId != 0)
+    {
+        return artId;
+    }
+
+    pStmt = createStatement("INSERT INTO albumArt (Id, Hash, Data) VALUES (NULL, ?, ?);");
+    bindInt64(pStmt, hash, 1);
+    bindValue(pStmt, &data.front(), data.size(), 2);
+    performQuery(pStmt);
+
+    return static_cast<uint32_t>(sqlite3_last_insert_rowid(m_pDb));
+}
+
+void MusicDb::removeUnusedAlbumArt()
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    performQuery(createStatement("DELETE FROM albumArt WHERE NOT EXISTS (SELECT 1 FROM albums WHERE albums.ArtId = albumArt.Id);"));
+
+    uint32_t removed = sqlite3_changes(m_pDb);
+    if (removed > 0)
+    {
+        log::debug("Removed %d unused album art entries", removed);
+    }
+}
+
+void MusicDb::removeTrack(const ItemId& id)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        Statement pStmt = createStatement("DELETE from tracks WHERE Id = ?");
+        bindValue(pStmt, id, 1);
+        performQuery(pStmt);
+        m_TrackSampler.invalidate();
+    }
+    
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.deletedTrack(id); });
+}
+
+void MusicDb::removeAlbum(const ItemId& id)
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        Statement pStmt = createStatement("DELETE from albums WHERE Id = ?");
+        bindValue(pStmt, id, 1);
+        performQuery(pStmt);
+        removeUnusedAlbumArt();
+        forgetAlbum(id);
+    }
+    
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.deletedAlbum(id); });
+}
+
+void MusicDb::forgetAlbum(const ItemId& id)
+{
+    auto iter = m_AlbumNames.find(static_cast<uint32_t>(id.toInt()));
+    if (iter != m_AlbumNames.end())
+    {
+        forgetAlbumName(iter->second, iter->first);
+        m_AlbumNames.erase(iter);
+    }
+
+    m_AlbumSampler.invalidate();
+}
+
+// another album with the same title keeps its entry
+void MusicDb::forgetAlbumName(const std::string& name, uint32_t albumId)
+{
+    auto iter = m_AlbumIds.find(name);
+    if (iter != m_AlbumIds.end() && iter->second == albumId)
+    {
+        m_AlbumIds.erase(iter);
+    }
+}
+
+void MusicDb::removeNonExistingFiles()
+{
+    typedef sql::Query<col::FileTrackId, col::FileDirectoryId, col::FileName, col::FilePath> FilesQuery;
+
+    auto start = std::chrono::steady_clock::now();
+    vector<int64_t> ids;
+    vector<int64_t> directoryIds;
+    vector<string> filenames;
+    vector<string> paths;
+
+    // the file system is checked on a snapshot, the database is not locked
+    // while waiting for the stat calls
+    {
+        ReadConnection db(*this);
+        forEachRow<FilesQuery>(createStatement(db, FilesQuery::text("FROM tracks INNER JOIN directories ON directories.Id = tracks.DirectoryId;")), [&] (const FilesQuery::RowType& row) {
+            ids.push_back(row.get<col::FileTrackId>());
+            directoryIds.push_back(row.get<col::FileDirectoryId>());
+            filenames.push_back(row.get<col::FileName>().str());
+            paths.push_back(row.get<col::FilePath>().str());
+        });
+    }
+
+    vector<uint8_t> missing = findMissingPaths(paths);
+    vector<ItemId> removedIds;
+
+    {
+        Savepoint savepoint(*this, "removeFiles");
+        for (size_t i = 0; i < ids.size(); ++i)
+        {
+            if (!missing[i])
+            {
+                continue;
+            }
+
+            // the path is compared as well, the track could have been updated after the snapshot
+            Statement pStmt = createStatement("DELETE FROM tracks WHERE Id = ? AND DirectoryId = ? AND Filename = ?;");
+            bindInt64(pStmt, ids[i], 1);
+            bindInt64(pStmt, directoryIds[i], 2);
+            bindText(pStmt, filenames[i], 3);
+            performQuery(pStmt);
+
+            if (sqlite3_changes(m_pDb) > 0)
+            {
+                log::debug("Removed deleted file from database: %s", paths[i]);
+                removedIds.push_back(ItemId(ids[i]));
+            }
+        }
+
+        if (!removedIds.empty())
+        {
+            removeUnusedDirectories();
+        }
+
+        savepoint.release();
+
+        if (!removedIds.empty())
+        {
+            m_TrackSampler.invalidate();
+            m_MaintenanceDue = true;
+        }
+    }
+
+    log::info("Checked %d files, removed %d (%d ms)", paths.size(), removedIds.size(), getElapsedMilliseconds(start));
+
+    if (!removedIds.empty())
+    {
+        notify([=] (ILibrarySubscriber& subscriber) { subscriber.deletedTracks(removedIds); });
+    }
+}
+
+void MusicDb::removeDirectory(const std::string& path)
+{
+    // the paths of the subdirectories start with the path of the directory
+    // followed by a separator, the range covers them on the unique index
+    string first = getDirectoryPath(path);
+    if (first.empty())
+    {
+        return;
+    }
+
+    string last = first;
+    ++last.back();
+
+    vector<ItemId> removedIds;
+
+    {
+        Savepoint savepoint(*this, "removeDirectory");
+        Statement pStmt = createStatement("SELECT Id FROM tracks WHERE DirectoryId IN (SELECT Id FROM directories WHERE Path >= ? AND Path < ?);");
+        bindValue(pStmt, first, 1);
+        bindValue(pStmt, last, 2);
+        performQuery(pStmt, getIdsCb, &removedIds);
+
+        if (!removedIds.empty())
+        {
+            pStmt = createStatement("DELETE FROM tracks WHERE DirectoryId IN (SELECT Id FROM directories WHERE Path >= ? AND Path < ?);");
+            bindValue(pStmt, first, 1);
+            bindValue(pStmt, last, 2);
+            performQuery(pStmt);
+        }
+
+        // the fingerprints of the removed directories go as well, also
+        // of the directories without tracks
+        pStmt = createStatement("DELETE FROM directories WHERE Path >= ? AND Path < ?;");
+        bindValue(pStmt, first, 1);
+        bindValue(pStmt, last, 2);
+        performQuery(pStmt);
+
+        if (sqlite3_changes(m_pDb) == 0)
+        {
+            return;
+        }
+
+        loadDirectoryIds();
+        savepoint.release();
+
+        if (removedIds.empty())
+        {
+            return;
+        }
+
+        m_TrackSampler.invalidate();
+        m_MaintenanceDue = true;
+    }
+
+    log::info("Removed %d tracks in %s", removedIds.size(), path);
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.deletedTracks(removedIds); });
+}
+
+bool MusicDb::isDirectoryUnchanged(const std::string& path, uint32_t modifiedTime, uint32_t entryCount)
+{
+    string directory = getDirectoryPath(path);
+
+    ReadConnection db(*this);
+    Statement pStmt = createStatement(db, "SELECT COUNT(*) FROM directories WHERE Path = ? AND ModifiedTime = ? AND EntryCount = ?;");
+    bindText(pStmt, directory, 1);
+    bindValue(pStmt, modifiedTime, 2);
+    bindValue(pStmt, entryCount, 3);
+
+    uint32_t count = 0;
+    performQuery(pStmt, countCb, &count);
+    return count > 0;
+}
+
+void MusicDb::setDirectoryFingerprint(const std::string& path, uint32_t modifiedTime, uint32_t entryCount)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+
+    Statement pStmt = createStatement("UPDATE directories SET ModifiedTime = ?, EntryCount = ? WHERE Id = ?;");
+    bindValue(pStmt, modifiedTime, 1);
+    bindValue(pStmt, entryCount, 2);
+    bindValue(pStmt, addDirectoryIfNotExists(getDirectoryPath(path)), 3);
+    performQuery(pStmt);
+}
+
+// A directory without tracks keeps its fingerprint as long as it exists,
+// otherwise its other files are read again on the next scan
+void MusicDb::removeUnusedDirectories()
+{
+    performQuery(createStatement(
+        "DELETE FROM directories "
+        "WHERE ModifiedTime IS NULL AND NOT EXISTS (SELECT 1 FROM tracks WHERE tracks.DirectoryId = directories.Id);"));
+    int32_t removed = sqlite3_changes(m_pDb);
+
+    IdMap fingerprinted;
+    performQuery(createStatement(
+        "SELECT Id, Path FROM directories "
+        "WHERE ModifiedTime IS NOT NULL AND NOT EXISTS (SELECT 1 FROM tracks WHERE tracks.DirectoryId = directories.Id);"), getNameIdsCb, &fingerprinted);
+
+    for (auto& directory : fingerprinted)
+    {
+        if (!fileops::pathExists(directory.first))
+        {
+            Statement pStmt = createStatement("DELETE FROM directories WHERE Id = ?;");
+            bindValue(pStmt, directory.second, 1);
+            performQuery(pStmt);
+            ++removed;
+        }
+    }
+
+    if (removed > 0)
+    {
+        loadDirectoryIds();
+    }
+}
+
+void MusicDb::loadDirectoryIds()
+{
+    m_DirectoryIds.clear();
+    performQuery(createStatement("SELECT Id, Path FROM directories;"), getNameIdsCb, &m_DirectoryIds);
+}
+
+void MusicDb::removeNonExistingAlbums()
+{
+    auto start = std::chrono::steady_clock::now();
+    vector<ItemId> albumIds;
+
+    {
+        Savepoint savepoint(*this, "removeAlbums");
+        performQuery(createStatement(
+            "SELECT Id FROM albums "
+            "WHERE NOT EXISTS (SELECT 1 FROM tracks WHERE tracks.AlbumId = albums.Id);"), getIdsCb, &albumIds);
+
+        if (albumIds.empty())
+        {
+            return;
+        }
+
+        performQuery(createStatement(
+            "DELETE FROM albums "
+            "WHERE NOT EXISTS (SELECT 1 FROM tracks WHERE tracks.AlbumId = albums.Id);"));
+        removeUnusedAlbumArt();
+        savepoint.release();
+
+        for (auto& id : albumIds)
+        {
+            forgetAlbum(id);
+        }
+
+        m_MaintenanceDue = true;
+    }
+
+    log::info("Removed %d albums without tracks (%d ms)", albumIds.size(), getElapsedMilliseconds(start));
+    notify([=] (ILibrarySubscriber& subscriber) { subscriber.deletedAlbums(albumIds); });
+}
+
+// UPDATE ... FROM and RETURNING need sqlite 3.35, the build checks the version
+void MusicDb::updateAlbumMetaData()
+{
+    auto start = std::chrono::steady_clock::now();
+    vector<ItemId> albumIds;
+
+    {
+        Savepoint savepoint(*this, "updateAlbums");
+        performQuery(createStatement(
+            "UPDATE albums "
+            "SET Duration = totals.Duration, DiscCount = totals.DiscCount "
+            "FROM (SELECT AlbumId, SUM(Duration) AS Duration, MAX(DiscNr) AS DiscCount FROM tracks GROUP BY AlbumId) AS totals "
+            "WHERE albums.Id = totals.AlbumId "
+            "AND (albums.Duration IS NOT totals.Duration OR albums.DiscCount IS NOT totals.DiscCount) "
+            "RETURNING Id;"), getIdsCb, &albumIds);
+        savepoint.release();
+    }
+
+    log::info("Updated the metadata of %d albums (%d ms)", albumIds.size(), getElapsedMilliseconds(start));
+
+    for (auto& id : albumIds)
+    {
+        Album album;
+        if (getAlbum(id, album))
+        {
+            notify([=] (ILibrarySubscriber& subscriber) { subscriber.updatedAlbum(album); });
+        }
+    }
+}
+
+// Turns the search string into an fts query: every word is quoted so the
+// fts syntax characters lose their meaning and is matched as a prefix
+static string createSearchExpression(const string& search)
+{
+    string expression;
+
+    istringstream words(search);
+    string word;
+    while (words >> word)
+    {
+        string quotedWord;
+        for (auto c : word)
+        {
+            if (c == '"')
+            {
+                quotedWord += '"';
+            }
+
+            quotedWord += c;
+        }
+
+        if (!expression.empty())
+        {
+            expression += ' ';
+        }
+
+        expression += '"' + quotedWord + "\"*";
+    }
+
+    return expression;
+}
+
+void MusicDb::searchLibrary(const std::string& search, utils::ISubscriber<const Track&>& trackSubscriber, utils::ISubscriber<const Album&>& albumSubscriber)
+{
+    string expression = createSearchExpression(search);
+    if (expression.empty())
+    {
+        return;
+    }
+
+    typedef sql::Query<col::TrackId, col::TrackAlbumId, col::TrackTitle, col::TrackComposer, col::TrackFilepath, col::TrackYear,
+                       col::TrackNr, col::TrackDiscNr, col::TrackDuration, col::TrackBitRate, col::TrackSampleRate, col::TrackChannels,
+                       col::TrackFileSize, col::TrackModifiedTime, col::TrackArtist, col::TrackAlbum, col::TrackAlbumArtist, col::TrackGenre,
+                       col::AlbumId, col::AlbumName, col::AlbumArtist, col::AlbumYear, col::AlbumDuration, col::AlbumDateAdded, col::AlbumGenre> SearchQuery;
+    static const string query = SearchQuery::text(
+            "FROM trackSearch "
+            "INNER JOIN trackInfo ON trackInfo.Id = trackSearch.rowid "
+            "LEFT OUTER JOIN albums ON trackInfo.AlbumId = albums.Id "
+            "LEFT OUTER JOIN genres AS albumGenres ON albums.GenreId = albumGenres.Id "
+            "WHERE trackSearch MATCH ? "
+            "ORDER BY trackSearch.rank;");
+
+    Track track;
+    set<int64_t> albumIds;
+    vector<Album> albums;
+
+    {
+        ReadConnection db(*this);
+        Statement pStmt = createStatement(db, query);
+        bindValue(pStmt, expression, 1);
+
+        forEachRow<SearchQuery>(pStmt, [&] (const SearchQuery::RowType& row) {
+            getTrackFromRow(row, track);
+            trackSubscriber.onItem(track);
+
+            // only the first track of an album creates the album
+            if (!row.isNull<col::TrackAlbumId>() && albumIds.insert(row.get<col::TrackAlbumId>()).second)
+            {
+                albums.push_back(Album());
+                getAlbumFromRow(row, albums.back());
+            }
+        });
+    }
+
+    for (size_t i = 0; i < albums.size(); ++i)
+    {
+        albumSubscriber.onItem(albums[i]);
+    }
+}
+
+void MusicDb::clearDatabase()
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        performQuery(createStatement("DROP INDEX IF EXISTS tracks.pathIndex;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS albums;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS albumArt;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS artists;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS genres;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS tracks;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS trackSearch;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS trackInfo;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS directories;"));
+        performQuery(createStatement("DROP TABLE IF EXISTS schemaInfo;"));
+
+        // the empty database is cheap to rebuild, this also switches databases
+        // from before the incremental vacuum support
+        if (!m_BatchActive)
+        {
+            performQuery(createStatement("PRAGMA auto_vacuum=INCREMENTAL;"));
+            performQuery(createStatement("VACUUM;"));
+        }
+
+        migrateSchema();
+        loadIdCaches();
+        m_TrackSampler.invalidate();
+        m_AlbumSampler.invalidate();
+        m_MaintenanceDue = true;
     }
     
-    if (m_pSubscriber)
-    {
-        m_pSubscriber->deletedTrack(id);
-    }
+    notify([] (ILibrarySubscriber& subscriber) { subscriber.libraryCleared(); });
 }
 
-void MusicDb::removeAlbum(const std::string& id)
+void MusicDb::migrateSchema()
 {
+    typedef void (MusicDb::*MigrationFunc)();
+    struct Migration
     {
-        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-        sqlite3_stmt* pStmt = createStatement("DELETE from albums WHERE Id = ?");
-        bindValue(pStmt, id, 1);
-        performQuery(pStmt);
-    }
-    
-    if (m_pSubscriber)
+        uint32_t        version;
+        const char*     description;
+        MigrationFunc   apply;
+    };
+
+    // Schema changes in the order they were introduced, a migration must also
+    // succeed on a database that already contains (part of) its changes.
+    static const Migration migrations[] =
     {
-        m_pSubscriber->deletedAlbum(id);
-    }
-}
+        { 1, "initial tables",          &MusicDb::createInitialDatabase },
+        { 2, "album art table",         &MusicDb::createAlbumArtStore },
+        { 3, "search index",            &MusicDb::createSearchIndex },
+        { 4, "album lookup indexes",    &MusicDb::createAlbumIndexes },
+        { 5, "track info table",        &MusicDb::createTrackInfo },
+        { 6, "album artist index",      &MusicDb::createAlbumArtistIndex },
+        { 7, "directory table",         &MusicDb::createDirectories },
+        { 8, "directory fingerprints",  &MusicDb::createDirectoryFingerprints },
+    };
 
-void MusicDb::removeNonExistingFiles()
-{
     std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    vector<uint32_t> files;
-    performQuery(createStatement("SELECT Id, Filepath from tracks;"), removeNonExistingFilesCb, &files);
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS schemaInfo(Version INTEGER NOT NULL);"));
 
-    for (size_t i = 0; i < files.size(); ++i)
+    uint32_t version = getSchemaVersion();
+    if (version == 0)
     {
-        log::debug("Removed deleted file from database: %s", files[i]);
-        removeTrack(numericops::toString(files[i]));
+        log::info("Creating new database");
     }
-}
-
-void MusicDb::removeNonExistingAlbums()
-{
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    set<uint32_t> albums;
-    performQuery(createStatement("SELECT Id from albums;"), getAllAlbumIdsCb, &albums);
 
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT COUNT(Id) "
-        "FROM tracks "
-        "WHERE tracks.AlbumId = ?;");
-
-    vector<uint32_t> albumsToBeRemoved;
-    for (set<uint32_t>::iterator iter = albums.begin(); iter != albums.end(); ++iter)
+    for (auto& migration : migrations)
     {
-        uint32_t count;
-        bindValue(pStmt, *iter, 1);
-        performQuery(pStmt, countCb, &count, false);
-
-        if (count == 0)
+        if (migration.version <= version)
         {
-            log::debug("Removed album without tracks from database: %d",  *iter);
-            albumsToBeRemoved.push_back(*iter);
+            continue;
         }
 
-        if (sqlite3_reset(pStmt) != SQLITE_OK)
+        if (version > 0)
         {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to reset statement: ") + sqlite3_errmsg(m_pDb));
-        }
-        if (sqlite3_clear_bindings(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to clear bindings: ") + sqlite3_errmsg(m_pDb));
+            log::info("Upgrading database to version %d: %s", migration.version, migration.description);
         }
+
+        Savepoint savepoint(*this, "migration");
+        (this->*migration.apply)();
+        setSchemaVersion(migration.version);
+        savepoint.release();
     }
-    sqlite3_finalize(pStmt);
+}
 
-    for (size_t i = 0; i < albumsToBeRemoved.size(); ++i)
+uint32_t MusicDb::getSchemaVersion()
+{
+    uint32_t count = 0;
+    performQuery(createStatement("SELECT COUNT(*) FROM schemaInfo;"), countCb, &count);
+    if (count > 0)
     {
-        removeAlbum(numericops::toString(albumsToBeRemoved[i]));
+        uint32_t version = 0;
+        performQuery(createStatement("SELECT MAX(Version) FROM schemaInfo;"), countCb, &version);
+        return version;
     }
+
+    // databases from before the schema versioning have the initial tables
+    performQuery(createStatement("SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='albums';"), countCb, &count);
+    return count > 0 ? 1 : 0;
 }
 
-void MusicDb::updateAlbumMetaData()
+void MusicDb::setSchemaVersion(uint32_t version)
 {
-    vector<uint32_t> albums;
-    performQuery(createStatement("SELECT Id from albums;"), getAllAlbumIdsCb, &albums);
+    performQuery(createStatement("DELETE FROM schemaInfo;"));
 
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT Duration DiscNr "
-        "FROM tracks "
-        "WHERE tracks.AlbumId = ?;");
+    Statement pStmt = createStatement("INSERT INTO schemaInfo (Version) VALUES (?);");
+    bindValue(pStmt, version, 1);
+    performQuery(pStmt);
+}
 
-    map<uint32_t, uint32_t> albumDurations;
-    for (size_t i = 0; i < albums.size(); ++i)
-    {
-        uint32_t totalDuration = 0;
-        bindValue(pStmt, albums[i], 1);
-        performQuery(pStmt, addResultCb, &totalDuration, false);
+int32_t MusicDb::getPragma(const std::string& name)
+{
+    uint32_t value = 0;
+    performQuery(createStatement("PRAGMA " + name + ";"), countCb, &value);
+    return static_cast<int32_t>(value);
+}
 
-        albumDurations[albums[i]] = totalDuration;
+void MusicDb::createInitialDatabase()
+{
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS albums(Id INTEGER PRIMARY KEY, GenreId INTEGER, Name TEXT, AlbumArtist TEXT, Year INTEGER, Duration Integer, DiscCount INTEGER, DateAdded INTEGER, CoverImage BLOB, FOREIGN KEY (GenreId) REFERENCES genres(Id));"));
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS artists(Id INTEGER PRIMARY KEY, Name TEXT UNIQUE);"));
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS genres(Id INTEGER PRIMARY KEY, Name TEXT UNIQUE);"));
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS tracks(Id INTEGER PRIMARY KEY, AlbumId INTEGER, ArtistId INTEGER, GenreId INTEGER, Title TEXT, Filepath TEXT UNIQUE, Composer TEXT, Year INTEGER, TrackNr INTEGER, DiscNr INTEGER, AlbumOrder INTEGER, Duration INTEGER, BitRate INTEGER, SampleRate INTEGER, Channels INTEGER, FileSize INTEGER, ModifiedTime INTEGER, FOREIGN KEY (AlbumId) REFERENCES albums(Id), FOREIGN KEY (ArtistId) REFERENCES artists(Id), FOREIGN KEY (GenreId) REFERENCES genres(Id));"));
 
-        if (sqlite3_reset(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to reset statement: ") + sqlite3_errmsg(m_pDb));
-        }
-        if (sqlite3_clear_bindings(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to clear bindings: ") + sqlite3_errmsg(m_pDb));
-        }
-    }
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS pathIndex ON tracks (Filepath);"));
+}
 
-    sqlite3_finalize(pStmt);
+bool MusicDb::columnExists(const std::string& table, const std::string& column)
+{
+    // the table name can't be bound in a pragma
+    Statement pStmt = createStatement("SELECT COUNT(*) FROM pragma_table_info('" + table + "') WHERE name = ?;");
+    bindValue(pStmt, column, 1);
 
-    pStmt = createStatement(
-        "UPDATE albums "
-        "SET Duration=? "
-        "WHERE albums.Id = ?;");
+    uint32_t count = 0;
+    performQuery(pStmt, countCb, &count);
+    return count > 0;
+}
+
+// Moves the art that was stored inline in the albums table to the album art table
+void MusicDb::createAlbumArtStore()
+{
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS albumArt(Id INTEGER PRIMARY KEY, Hash INTEGER NOT NULL, Data BLOB NOT NULL);"));
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS artHashIndex ON albumArt (Hash);"));
 
-    for (map<uint32_t, uint32_t>::iterator iter = albumDurations.begin(); iter != albumDurations.end(); ++iter)
+    if (!columnExists("albums", "ArtId"))
     {
-        bindValue(pStmt, iter->second, 1);
-        bindValue(pStmt, iter->first, 2);
-        performQuery(pStmt, nullptr, nullptr, false);
+        performQuery(createStatement("ALTER TABLE albums ADD COLUMN ArtId INTEGER REFERENCES albumArt(Id);"));
+    }
 
-        if (sqlite3_reset(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to reset statement: ") + sqlite3_errmsg(m_pDb));
-        }
-        if (sqlite3_clear_bindings(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to clear bindings: ") + sqlite3_errmsg(m_pDb));
-        }
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS albumArtIndex ON albums (ArtId);"));
+
+    if (!columnExists("albums", "CoverImage"))
+    {
+        return;
     }
 
-    sqlite3_finalize(pStmt);
-}
+    vector<ItemId> albumIds;
+    performQuery(createStatement("SELECT Id FROM albums WHERE CoverImage IS NOT NULL;"), getIdsCb, &albumIds);
 
-class SearchTrackData
-{
-public:
-    SearchTrackData(utils::ISubscriber<const Track&>& trackSubscriber, set<uint32_t>& foundIds)
-    : subscriber(trackSubscriber)
-    , ids(foundIds)
+    for (auto& albumId : albumIds)
     {
+        vector<uint8_t> data;
+        Statement pStmt = createStatement("SELECT CoverImage FROM albums WHERE Id = ?;");
+        bindValue(pStmt, albumId, 1);
+        performQuery(pStmt, getAlbumArtCb, &data);
+
+        pStmt = createStatement("UPDATE albums SET ArtId = ? WHERE Id = ?;");
+        bindId(pStmt, storeAlbumArt(data), 1);
+        bindValue(pStmt, albumId, 2);
+        performQuery(pStmt);
     }
 
-    utils::ISubscriber<const Track&>& subscriber;
-    set<uint32_t>&      ids;
-};
+    // DROP COLUMN needs sqlite 3.35, like updateAlbumMetaData
+    performQuery(createStatement("ALTER TABLE albums DROP COLUMN CoverImage;"));
 
-void MusicDb::searchLibrary(const std::string& search, utils::ISubscriber<const Track&>& trackSubscriber, utils::ISubscriber<const Album&>& albumSubscriber)
+    if (!albumIds.empty())
+    {
+        log::info("Moved the album art of %d albums to the album art table", albumIds.size());
+    }
+}
+
+void MusicDb::createAlbumIndexes()
 {
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS albumNameIndex ON albums (Name);"));
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS albumDateIndex ON albums (DateAdded);"));
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS albumTracksIndex ON tracks (AlbumId, AlbumOrder);"));
+}
 
-    set<uint32_t> albumIds;
-    sqlite3_stmt* pStmt = createStatement(
-        "SELECT Id "
-        "FROM albums "
-        "WHERE albums.AlbumArtist LIKE (SELECT '%' || ?1 || '%') "
-        "OR albums.Name LIKE (SELECT '%' || ?1 || '%');");
-    bindValue(pStmt, search, 1);
-    performQuery(pStmt, getAllAlbumIdsCb, &albumIds);
-
-    SearchTrackData data(trackSubscriber, albumIds);
-    pStmt = createStatement(
-        "SELECT tracks.Id, tracks.AlbumId, tracks.Title, tracks.Composer, tracks.Filepath, tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
-        "FROM tracks "
+// trackInfo holds the tracks joined with their album, artist and genre names so
+// reading a track doesn't need any joins. The normalized tables remain the
+// source of truth, triggers keep trackInfo up to date.
+void MusicDb::createTrackInfo()
+{
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS trackInfo(Id INTEGER PRIMARY KEY, AlbumId INTEGER, Title TEXT, Composer TEXT, Filepath TEXT, Year INTEGER, TrackNr INTEGER, DiscNr INTEGER, AlbumOrder INTEGER, Duration INTEGER, BitRate INTEGER, SampleRate INTEGER, Channels INTEGER, FileSize INTEGER, ModifiedTime INTEGER, Artist TEXT, Album TEXT, AlbumArtist TEXT, Genre TEXT);"));
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS trackInfoAlbumIndex ON trackInfo (AlbumId, AlbumOrder);"));
+    createTrackInfoTriggers();
+
+    // the tracks table can already be rebuilt with the directory table
+    bool directories = !columnExists("tracks", "Filepath");
+
+    // the table could be partially filled by an earlier attempt
+    performQuery(createStatement(string(
+        "INSERT OR REPLACE INTO trackInfo (Id, AlbumId, Title, Composer, Filepath, Year, TrackNr, DiscNr, AlbumOrder, Duration, BitRate, SampleRate, Channels, FileSize, ModifiedTime, Artist, Album, AlbumArtist, Genre) "
+        "SELECT tracks.Id, tracks.AlbumId, tracks.Title, tracks.Composer, ") + (directories ? "directories.Path || tracks.Filename" : "tracks.Filepath") + ", tracks.Year, tracks.TrackNr, tracks.DiscNr, tracks.AlbumOrder, tracks.Duration, tracks.BitRate, tracks.SampleRate, tracks.Channels, tracks.FileSize, tracks.ModifiedTime, "
+        "artists.Name, albums.Name, albums.AlbumArtist, genres.Name "
+        "FROM tracks " + (directories ? "LEFT OUTER JOIN directories ON tracks.DirectoryId = directories.Id " : "") +
         "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
         "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
-        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id "
-        "WHERE artists.Name LIKE (SELECT '%' || ?1 || '%')"
-        "OR tracks.title LIKE (SELECT '%' || ?1 || '%');");
-
+        "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id;"));
+}
 
-    bindValue(pStmt, search, 1);
-    performQuery(pStmt, searchTracksCb, &data);
+// The triggers are created with the current layout of the tracks table, a
+// database that is upgraded from before the directory table gets them again
+// when the tracks table is rebuilt.
+void MusicDb::createTrackInfoTriggers()
+{
+    performQuery(createStatement(string("CREATE TRIGGER IF NOT EXISTS trackInfoInsert AFTER INSERT ON tracks BEGIN ") + TRACK_INFO_INSERT + "END;"));
+    performQuery(createStatement(string(
+        "CREATE TRIGGER IF NOT EXISTS trackInfoUpdate AFTER UPDATE ON tracks BEGIN "
+        "DELETE FROM trackInfo WHERE Id = OLD.Id; ") + TRACK_INFO_INSERT + "END;"));
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackInfoDelete AFTER DELETE ON tracks BEGIN "
+        "DELETE FROM trackInfo WHERE Id = OLD.Id; "
+        "END;"));
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackInfoAlbumUpdate AFTER UPDATE OF Name, AlbumArtist ON albums "
+        "WHEN OLD.Name IS NOT NEW.Name OR OLD.AlbumArtist IS NOT NEW.AlbumArtist BEGIN "
+        "UPDATE trackInfo SET Album = NEW.Name, AlbumArtist = NEW.AlbumArtist WHERE AlbumId = NEW.Id; "
+        "END;"));
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackInfoAlbumDelete AFTER DELETE ON albums BEGIN "
+        "UPDATE trackInfo SET Album = NULL, AlbumArtist = NULL WHERE AlbumId = OLD.Id; "
+        "END;"));
+}
 
-    vector<Album> albums;
-    pStmt = createStatement(
-        "SELECT albums.Id, albums.Name, albums.AlbumArtist, albums.Year, albums.Duration, albums.DateAdded, genres.Name "
-        "FROM albums "
-    	"LEFT OUTER JOIN genres ON albums.GenreId = genres.Id "
-        "WHERE albums.Id=?;");
+// The tracks store their directory and file name instead of the full path, the
+// path of a directory is stored once. sqlite can't drop the unique Filepath
+// column so the tracks table is rebuilt, which also drops its triggers.
+void MusicDb::createDirectories()
+{
+    performQuery(createStatement("CREATE TABLE IF NOT EXISTS directories(Id INTEGER PRIMARY KEY, Path TEXT NOT NULL UNIQUE);"));
 
-    for (set<uint32_t>::iterator iter = data.ids.begin(); iter != data.ids.end(); ++iter)
+    if (columnExists("tracks", "Filepath"))
     {
-        bindValue(pStmt, *iter, 1);
-        performQuery(pStmt, getAlbumListCb, &albums, false);
-
-        if (sqlite3_reset(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to reset statement: ") + sqlite3_errmsg(m_pDb));
-        }
-        if (sqlite3_clear_bindings(pStmt) != SQLITE_OK)
-        {
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to clear bindings: ") + sqlite3_errmsg(m_pDb));
-        }
+        m_DirectoryIds.clear();
+
+        // refers to the tracks table, the rename fails while it is dropped
+        performQuery(createStatement("DROP TRIGGER IF EXISTS trackSearchAlbumUpdate;"));
+
+        performQuery(createStatement("DROP TABLE IF EXISTS tracksNew;"));
+        performQuery(createStatement("CREATE TABLE tracksNew(Id INTEGER PRIMARY KEY, AlbumId INTEGER, ArtistId INTEGER, GenreId INTEGER, Title TEXT, DirectoryId INTEGER, Filename TEXT, Composer TEXT, Year INTEGER, TrackNr INTEGER, DiscNr INTEGER, AlbumOrder INTEGER, Duration INTEGER, BitRate INTEGER, SampleRate INTEGER, Channels INTEGER, FileSize INTEGER, ModifiedTime INTEGER, FOREIGN KEY (AlbumId) REFERENCES albums(Id), FOREIGN KEY (ArtistId) REFERENCES artists(Id), FOREIGN KEY (GenreId) REFERENCES genres(Id), FOREIGN KEY (DirectoryId) REFERENCES directories(Id));"));
+
+        typedef sql::Query<col::FileTrackId, col::FileLegacyPath> PathQuery;
+        forEachRow<PathQuery>(createStatement(PathQuery::text("FROM tracks;")), [&] (const PathQuery::RowType& row) {
+            string directory, filename;
+            splitFilepath(row.get<col::FileLegacyPath>().str(), directory, filename);
+
+            Statement pStmt = createStatement(
+                "INSERT INTO tracksNew "
+                "SELECT Id, AlbumId, ArtistId, GenreId, Title, ?, ?, Composer, Year, TrackNr, DiscNr, AlbumOrder, Duration, BitRate, SampleRate, Channels, FileSize, ModifiedTime "
+                "FROM tracks WHERE Id = ?;");
+            bindValue(pStmt, addDirectoryIfNotExists(directory), 1);
+            bindText(pStmt, filename, 2);
+            bindInt64(pStmt, row.get<col::FileTrackId>(), 3);
+            performQuery(pStmt);
+        });
+
+        performQuery(createStatement("DROP TABLE tracks;"));
+        performQuery(createStatement("ALTER TABLE tracksNew RENAME TO tracks;"));
+        performQuery(createStatement("CREATE INDEX IF NOT EXISTS albumTracksIndex ON tracks (AlbumId, AlbumOrder);"));
+
+        createSearchTriggers();
+        createTrackInfoTriggers();
     }
-    sqlite3_finalize(pStmt);
 
-    for (size_t i = 0; i < albums.size(); ++i)
-    {
-        albumSubscriber.onItem(albums[i]);
-    }
+    performQuery(createStatement("CREATE UNIQUE INDEX IF NOT EXISTS trackFileIndex ON tracks (DirectoryId, Filename);"));
 }
 
-void MusicDb::clearDatabase()
+// the state of a directory when its files were scanned, NULL until the next scan
+void MusicDb::createDirectoryFingerprints()
 {
+    if (!columnExists("directories", "ModifiedTime"))
     {
-        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-        performQuery(createStatement("DROP INDEX IF EXISTS tracks.pathIndex;"));
-        performQuery(createStatement("DROP TABLE IF EXISTS albums;"));
-        performQuery(createStatement("DROP TABLE IF EXISTS artists;"));
-        performQuery(createStatement("DROP TABLE IF EXISTS genres;"));
-        performQuery(createStatement("DROP TABLE IF EXISTS tracks;"));
-
-        createInitialDatabase();
+        performQuery(createStatement("ALTER TABLE directories ADD COLUMN ModifiedTime INTEGER;"));
     }
-    
-    if (m_pSubscriber)
+
+    if (!columnExists("directories", "EntryCount"))
     {
-        m_pSubscriber->libraryCleared();
+        performQuery(createStatement("ALTER TABLE directories ADD COLUMN EntryCount INTEGER;"));
     }
 }
 
-void MusicDb::createInitialDatabase()
+// the albums without an artist sort first in a paged listing by artist
+void MusicDb::createAlbumArtistIndex()
 {
-	log::debug("Create initial database");
-    std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
-    log::debug("Lock acquired");
-    performQuery(createStatement("CREATE TABLE IF NOT EXISTS albums(Id INTEGER PRIMARY KEY, GenreId INTEGER, Name TEXT, AlbumArtist TEXT, Year INTEGER, Duration Integer, DiscCount INTEGER, DateAdded INTEGER, CoverImage BLOB, FOREIGN KEY (GenreId) REFERENCES genres(Id));"));
-    performQuery(createStatement("CREATE TABLE IF NOT EXISTS artists(Id INTEGER PRIMARY KEY, Name TEXT UNIQUE);"));
-    performQuery(createStatement("CREATE TABLE IF NOT EXISTS genres(Id INTEGER PRIMARY KEY, Name TEXT UNIQUE);"));
-    performQuery(createStatement("CREATE TABLE IF NOT EXISTS tracks(Id INTEGER PRIMARY KEY, AlbumId INTEGER, ArtistId INTEGER, GenreId INTEGER, Title TEXT, Filepath TEXT UNIQUE, Composer TEXT, Year INTEGER, TrackNr INTEGER, DiscNr INTEGER, AlbumOrder INTEGER, Duration INTEGER, BitRate INTEGER, SampleRate INTEGER, Channels INTEGER, FileSize INTEGER, ModifiedTime INTEGER, FOREIGN KEY (AlbumId) REFERENCES albums(Id), FOREIGN KEY (ArtistId) REFERENCES artists(Id), FOREIGN KEY (GenreId) REFERENCES genres(Id));"));
+    performQuery(createStatement("CREATE INDEX IF NOT EXISTS albumArtistIndex ON albums (IFNULL(AlbumArtist, ''));"));
+}
 
-    performQuery(createStatement("CREATE INDEX IF NOT EXISTS pathIndex ON tracks (Filepath);"));
+void MusicDb::createSearchIndex()
+{
+    uint32_t count;
+    performQuery(createStatement("SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='trackSearch';"), countCb, &count);
+    bool populate = (count == 0);
 
-    log::debug("database created");
+    performQuery(createStatement("CREATE VIRTUAL TABLE IF NOT EXISTS trackSearch USING fts5(Title, Artist, Album, AlbumArtist, Composer, Genre, tokenize='unicode61 remove_diacritics 1', prefix='2 3');"));
+    createSearchTriggers();
+
+    if (populate)
+    {
+        log::debug("Building search index");
+        performQuery(createStatement(
+            "INSERT INTO trackSearch (rowid, Title, Artist, Album, AlbumArtist, Composer, Genre) "
+            "SELECT tracks.Id, tracks.Title, artists.Name, albums.Name, albums.AlbumArtist, tracks.Composer, genres.Name "
+            "FROM tracks "
+            "LEFT OUTER JOIN albums ON tracks.AlbumId = albums.Id "
+            "LEFT OUTER JOIN artists ON tracks.ArtistId = artists.Id "
+            "LEFT OUTER JOIN genres ON tracks.GenreId = genres.Id;"));
+    }
+}
+
+// keep the search index in sync with the tracks, albums can be renamed by the scanner
+void MusicDb::createSearchTriggers()
+{
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackSearchInsert AFTER INSERT ON tracks BEGIN "
+        "INSERT INTO trackSearch (rowid, Title, Artist, Album, AlbumArtist, Composer, Genre) VALUES (NEW.Id, NEW.Title, "
+        "(SELECT Name FROM artists WHERE Id = NEW.ArtistId), (SELECT Name FROM albums WHERE Id = NEW.AlbumId), (SELECT AlbumArtist FROM albums WHERE Id = NEW.AlbumId), "
+        "NEW.Composer, (SELECT Name FROM genres WHERE Id = NEW.GenreId)); "
+        "END;"));
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackSearchUpdate AFTER UPDATE ON tracks BEGIN "
+        "DELETE FROM trackSearch WHERE rowid = OLD.Id; "
+        "INSERT INTO trackSearch (rowid, Title, Artist, Album, AlbumArtist, Composer, Genre) VALUES (NEW.Id, NEW.Title, "
+        "(SELECT Name FROM artists WHERE Id = NEW.ArtistId), (SELECT Name FROM albums WHERE Id = NEW.AlbumId), (SELECT AlbumArtist FROM albums WHERE Id = NEW.AlbumId), "
+        "NEW.Composer, (SELECT Name FROM genres WHERE Id = NEW.GenreId)); "
+        "END;"));
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackSearchDelete AFTER DELETE ON tracks BEGIN "
+        "DELETE FROM trackSearch WHERE rowid = OLD.Id; "
+        "END;"));
+    performQuery(createStatement(
+        "CREATE TRIGGER IF NOT EXISTS trackSearchAlbumUpdate AFTER UPDATE OF Name, AlbumArtist ON albums "
+        "WHEN OLD.Name IS NOT NEW.Name OR OLD.AlbumArtist IS NOT NEW.AlbumArtist BEGIN "
+        "UPDATE trackSearch SET Album = NEW.Name, AlbumArtist = NEW.AlbumArtist WHERE rowid IN (SELECT Id FROM tracks WHERE AlbumId = NEW.Id); "
+        "END;"));
 }
 
-uint32_t MusicDb::performQuery(sqlite3_stmt* pStmt, QueryCallback cb, void* pData, bool finalize)
+uint32_t MusicDb::performQuery(sqlite3_stmt* pStmt, QueryCallback cb, void* pData)
 {
+    // the statement is returned to the cache by its owner, the reset ends
+    // the read transaction right away, also when the callback throws
+    struct Reset
+    {
+        ~Reset() { sqlite3_reset(pStmt); }
+        sqlite3_stmt* pStmt;
+    } reset = { pStmt };
+
     uint32_t rowCount = 0;
 
     int32_t rc;
@@ -725,40 +1973,117 @@ uint32_t MusicDb::performQuery(sqlite3_stmt* pStmt, QueryCallback cb, void* pDat
         switch(rc)
         {
         case SQLITE_BUSY:
-            sqlite3_finalize(pStmt);
             throw logic_error("Failed to execute statement: SQL is busy");
             break;
         case SQLITE_ERROR:
-            sqlite3_finalize(pStmt);
-            throw logic_error(string("Failed to execute statement: ") + sqlite3_errmsg(m_pDb));
+            throw logic_error(string("Failed to execute statement: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
             break;
         case SQLITE_ROW:
             if (cb != nullptr) cb(pStmt, pData);
             ++rowCount;
             break;
         default:
-            sqlite3_finalize(pStmt);
             throw logic_error("FIXME: unhandled return value of sql statement: " + numericops::toString(rc));
         }
     }
 
-    if (finalize)
-    {
-        sqlite3_finalize(pStmt);
-    }
     return rowCount;
 }
 
-sqlite3_stmt* MusicDb::createStatement(const char* query)
+MusicDb::Statement MusicDb::createStatement(const std::string& query)
+{
+    return m_Statements.acquire(m_pDb, query);
+}
+
+MusicDb::Statement MusicDb::createStatement(sqlite3* pDb, const std::string& query)
+{
+    return m_Statements.acquire(pDb, query);
+}
+
+uint32_t MusicDb::performMaintenance(uint32_t timeBudgetInMs)
 {
-    sqlite3_stmt* pStmt;
+    auto start = std::chrono::steady_clock::now();
+    bool analyzed = false;
 
-    if (sqlite3_prepare_v2(m_pDb, query, -1, &pStmt, 0) != SQLITE_OK)
     {
-        throw logic_error(string("Failed to prepare sql statement (") + sqlite3_errmsg(m_pDb) + "): " + query);
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        if (m_BatchActive || m_BulkLoadActive)
+        {
+            log::debug("Database maintenance postponed, the database is being written");
+            return 0;
+        }
+
+        uint32_t statCount = 0;
+        performQuery(createStatement("SELECT COUNT(*) FROM sqlite_master WHERE name = 'sqlite_stat1';"), countCb, &statCount);
+
+        // a limited sample per index keeps ANALYZE short on big libraries
+        if (m_MaintenanceDue || statCount == 0)
+        {
+            performQuery(createStatement("PRAGMA analysis_limit=" + numericops::toString(ANALYSIS_ROW_LIMIT) + ";"));
+            performQuery(createStatement("ANALYZE;"));
+            analyzed = true;
+        }
+
+        performQuery(createStatement("PRAGMA optimize;"));
+        m_MaintenanceDue = false;
+    }
+
+    // the pages are freed in small steps, the other users of the database
+    // only have to wait for one step
+    uint32_t reclaimed = 0;
+    uint32_t freePages = 0;
+    bool incremental = false;
+    for (;;)
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        incremental = getPragma("auto_vacuum") == 2;
+        freePages = getPragma("freelist_count");
+        if (!incremental || freePages == 0 || m_BatchActive || getElapsedMilliseconds(start) >= timeBudgetInMs)
+        {
+            break;
+        }
+
+        performQuery(createStatement("PRAGMA incremental_vacuum(" + numericops::toString(VACUUM_STEP_PAGES) + ");"));
+        reclaimed += freePages - getPragma("freelist_count");
     }
 
-    return pStmt;
+    uint32_t pageSize;
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_DbMutex);
+        pageSize = getPragma("page_size");
+    }
+
+    log::info("Database maintenance took %d ms: %s, reclaimed %d KB, %d KB unused%s", getElapsedMilliseconds(start),
+              analyzed ? "statistics updated" : "statistics up to date",
+              (reclaimed * pageSize) / 1024, (freePages * pageSize) / 1024,
+              incremental ? "" : " (no incremental vacuum until the library is cleared)");
+
+    return reclaimed;
+}
+
+bool MusicDb::isMaintenanceDue()
+{
+    return m_MaintenanceDue;
+}
+
+StatementCache::Stats MusicDb::getStatementCacheStats()
+{
+    return m_Statements.getStats();
+}
+
+void MusicDb::setQueryProfiling(bool enabled, uint32_t logIntervalInSec)
+{
+    m_Profiler.setEnabled(enabled, logIntervalInSec);
+}
+
+std::vector<QueryProfiler::Entry> MusicDb::getQueryProfile()
+{
+    return m_Profiler.getEntries();
+}
+
+std::string MusicDb::dumpQueryProfile()
+{
+    return m_Profiler.dump();
 }
 
 void MusicDb::bindValue(sqlite3_stmt* pStmt, const string& value, int32_t index)
@@ -767,12 +2092,20 @@ void MusicDb::bindValue(sqlite3_stmt* pStmt, const string& value, int32_t index)
     {
         if (sqlite3_bind_null(pStmt, index) != SQLITE_OK)
         {
-            throw logic_error(string("Failed to bind string value as NULL: ") + sqlite3_errmsg(m_pDb));
+            throw logic_error(string("Failed to bind string value as NULL: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
         }
     }
     else if (sqlite3_bind_text(pStmt, index, value.c_str(), value.size(), SQLITE_STATIC) != SQLITE_OK)
     {
-        throw logic_error(string("Failed to bind string value: ") + sqlite3_errmsg(m_pDb));
+        throw logic_error(string("Failed to bind string value: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
+    }
+}
+
+void MusicDb::bindText(sqlite3_stmt* pStmt, const string& value, int32_t index)
+{
+    if (sqlite3_bind_text(pStmt, index, value.c_str(), value.size(), SQLITE_STATIC) != SQLITE_OK)
+    {
+        throw logic_error(string("Failed to bind text value: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
     }
 }
 
@@ -780,64 +2113,73 @@ void MusicDb::bindValue(sqlite3_stmt* pStmt, uint32_t value, int32_t index)
 {
     if (sqlite3_bind_int(pStmt, index, value) != SQLITE_OK )
     {
-        throw logic_error(string("Failed to bind int value: ") + sqlite3_errmsg(m_pDb));
+        throw logic_error(string("Failed to bind int value: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
     }
 }
 
-void MusicDb::bindValue(sqlite3_stmt* pStmt, const void* pData, uint32_t dataSize, int32_t index)
+void MusicDb::bindInt64(sqlite3_stmt* pStmt, int64_t value, int32_t index)
 {
-    if (pData == nullptr)
+    if (sqlite3_bind_int64(pStmt, index, value) != SQLITE_OK )
+    {
+        throw logic_error(string("Failed to bind int64 value: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
+    }
+}
+
+void MusicDb::bindId(sqlite3_stmt* pStmt, uint32_t id, int32_t index)
+{
+    if (id == 0)
     {
         if (sqlite3_bind_null(pStmt, index) != SQLITE_OK)
         {
-            throw logic_error(string("Failed to bind blob value as NULL: ") + sqlite3_errmsg(m_pDb));
+            throw logic_error(string("Failed to bind id as NULL: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
         }
     }
-    else if (sqlite3_bind_blob(pStmt, index, pData, dataSize, SQLITE_TRANSIENT) != SQLITE_OK)
+    else
     {
-        throw logic_error(string("Failed to bind int value: ") + sqlite3_errmsg(m_pDb));
+        bindValue(pStmt, id, index);
     }
 }
 
-void MusicDb::getIdFromTable(const string& table, const string& name, string& id)
-{
-    stringstream query;
-    query << "SELECT Id FROM " << table << " WHERE Name = ?;";
-    sqlite3_stmt* pStmt = createStatement(("SELECT Id FROM " + table + " WHERE Name = ?;").c_str());
-    bindValue(pStmt, name, 1);
-
-    id.clear();
-    performQuery(pStmt, getIdCb, &id);
-}
-
-uint32_t MusicDb::getIdFromTable(const string& table, const string& name)
+void MusicDb::bindValue(sqlite3_stmt* pStmt, const ItemId& id, int32_t index)
 {
-    stringstream query;
-    query << "SELECT Id FROM " << table << " WHERE Name = ?;";
-    sqlite3_stmt* pStmt = createStatement(("SELECT Id FROM " + table + " WHERE Name = ?;").c_str());
-    bindValue(pStmt, name, 1);
-
-    uint32_t id = 0;
-    performQuery(pStmt, getIdIntCb, &id);
-    return id;
+    if (id.empty())
+    {
+        if (sqlite3_bind_null(pStmt, index) != SQLITE_OK)
+        {
+            throw logic_error(string("Failed to bind id as NULL: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
+        }
+    }
+    else
+    {
+        bindInt64(pStmt, id.toInt(), index);
+    }
 }
 
-void MusicDb::getIdCb(sqlite3_stmt* pStmt, void* pData)
+void MusicDb::bindValue(sqlite3_stmt* pStmt, const void* pData, uint32_t dataSize, int32_t index)
 {
-    assert(sqlite3_column_count(pStmt) == 1);
-    assert(sqlite3_column_text(pStmt, 0));
-
-    string* pId = reinterpret_cast<string*>(pData);
-    *pId = reinterpret_cast<const char*>(sqlite3_column_text(pStmt, 0));
+    if (pData == nullptr)
+    {
+        if (sqlite3_bind_null(pStmt, index) != SQLITE_OK)
+        {
+            throw logic_error(string("Failed to bind blob value as NULL: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
+        }
+    }
+    else if (sqlite3_bind_blob(pStmt, index, pData, dataSize, SQLITE_TRANSIENT) != SQLITE_OK)
+    {
+        throw logic_error(string("Failed to bind int value: ") + sqlite3_errmsg(sqlite3_db_handle(pStmt)));
+    }
 }
 
-void MusicDb::getIdIntCb(sqlite3_stmt* pStmt, void* pData)
+void MusicDb::getNameIdsCb(sqlite3_stmt* pStmt, void* pData)
 {
-    assert(sqlite3_column_count(pStmt) == 1);
-    assert(sqlite3_column_text(pStmt, 0));
+    assert(sqlite3_column_count(pStmt) == 2);
 
-    uint32_t* pId = reinterpret_cast<uint32_t*>(pData);
-    *pId = sqlite3_column_int(pStmt, 0);
+    const char* pName = reinterpret_cast<const char*>(sqlite3_column_text(pStmt, 1));
+    if (pName != nullptr)
+    {
+        IdMap* pIds = reinterpret_cast<IdMap*>(pData);
+        (*pIds)[pName] = sqlite3_column_int(pStmt, 0);
+    }
 }
 
 static void getStringFromColumn(sqlite3_stmt* pStmt, int column, string& aString)
@@ -849,61 +2191,6 @@ static void getStringFromColumn(sqlite3_stmt* pStmt, int column, string& aString
     }
 }
 
-void MusicDb::getTrackInfoCb(sqlite3_stmt* pStmt, void* pData)
-{
-    assert(sqlite3_column_count(pStmt) == 18);
-
-    Track* pTrack = reinterpret_cast<Track*>(pData);
-
-    getStringFromColumn(pStmt, 0, pTrack->id);
-    getStringFromColumn(pStmt, 1, pTrack->albumId);
-    getStringFromColumn(pStmt, 2, pTrack->title);
-    getStringFromColumn(pStmt, 3, pTrack->composer);
-    getStringFromColumn(pStmt, 4, pTrack->filepath);
-
-    pTrack->year             = sqlite3_column_int(pStmt, 5);
-    pTrack->trackNr          = sqlite3_column_int(pStmt, 6);
-    pTrack->discNr           = sqlite3_column_int(pStmt, 7);
-    pTrack->durationInSec    = sqlite3_column_int(pStmt, 8);
-    pTrack->bitrate          = sqlite3_column_int(pStmt, 9);
-    pTrack->sampleRate       = sqlite3_column_int(pStmt, 10);
-    pTrack->channels         = sqlite3_column_int(pStmt, 11);
-    pTrack->fileSize         = sqlite3_column_int(pStmt, 12);
-    pTrack->modifiedTime     = sqlite3_column_int(pStmt, 13);
-
-    getStringFromColumn(pStmt, 14, pTrack->artist);
-    getStringFromColumn(pStmt, 15, pTrack->album);
-    getStringFromColumn(pStmt, 16, pTrack->albumArtist);
-    getStringFromColumn(pStmt, 17, pTrack->genre);
-}
-
-void MusicDb::getTrackModificationTimeCb(sqlite3_stmt* pStmt, void* pData)
-{
-    assert(sqlite3_column_count(pStmt) == 1);
-
-    uint32_t* pModifiedTime = reinterpret_cast<uint32_t*>(pData);
-    *pModifiedTime = sqlite3_column_int(pStmt, 0);
-}
-
-void MusicDb::getTracksCb(sqlite3_stmt* pStmt, void* pData)
-{
-	utils::ISubscriber<Track>* pSubscriber = reinterpret_cast<utils::ISubscriber<Track>*>(pData);
-
-    Track track;
-    getTrackInfoCb(pStmt, &track);
-    pSubscriber->onItem(track);
-}
-
-void MusicDb::searchTracksCb(sqlite3_stmt* pStmt, void* pData)
-{
-    SearchTrackData* pSearchData = reinterpret_cast<SearchTrackData*>(pData);
-
-    Track track;
-    getTrackInfoCb(pStmt, &track);
-    pSearchData->subscriber.onItem(track);
-    pSearchData->ids.insert(stringops::toNumeric<uint32_t>(track.albumId));
-}
-
 static void getDataFromColumn(sqlite3_stmt* pStmt, int column, vector<uint8_t>& data)
 {
 	int type = sqlite3_column_type(pStmt, column);
@@ -923,17 +2210,18 @@ static void getDataFromColumn(sqlite3_stmt* pStmt, int column, vector<uint8_t>&
 
 void MusicDb::getAlbumCb(sqlite3_stmt* pStmt, void* pData)
 {
-    assert(sqlite3_column_count(pStmt) == 7);
+    assert(sqlite3_column_count(pStmt) == 8);
 
     Album* pAlbum = reinterpret_cast<Album*>(pData);
 
-    getStringFromColumn(pStmt, 0, pAlbum->id);
+    pAlbum->id = ItemId(sqlite3_column_int64(pStmt, 0));
     getStringFromColumn(pStmt, 1, pAlbum->title);
     getStringFromColumn(pStmt, 2, pAlbum->artist);
     pAlbum->year = sqlite3_column_int(pStmt, 3);
     pAlbum->durationInSec = sqlite3_column_int(pStmt, 4);
     pAlbum->dateAdded = sqlite3_column_int(pStmt, 5);
     getStringFromColumn(pStmt, 6, pAlbum->genre);
+    pAlbum->discCount = sqlite3_column_int(pStmt, 7);
 }
 
 void MusicDb::getAlbumArtCb(sqlite3_stmt* pStmt, void* pData)
@@ -944,49 +2232,20 @@ void MusicDb::getAlbumArtCb(sqlite3_stmt* pStmt, void* pData)
     getDataFromColumn(pStmt, 0, *pAlbumArtData);
 }
 
-void MusicDb::getAlbumsCb(sqlite3_stmt* pStmt, void* pData)
-{
-    assert(sqlite3_column_count(pStmt) == 7);
-
-    utils::ISubscriber<Album>* pSubscriber = reinterpret_cast<utils::ISubscriber<Album>*>(pData);
-
-    Album album;
-    getAlbumCb(pStmt, &album);
-    pSubscriber->onItem(album);
-}
-
-void MusicDb::getAlbumListCb(sqlite3_stmt* pStmt, void* pData)
-{
-    assert(sqlite3_column_count(pStmt) == 7);
-
-    vector<Album>* pAlbums = reinterpret_cast<vector<Album>*>(pData);
-
-    Album album;
-    pAlbums->push_back(album);
-    getAlbumCb(pStmt, &pAlbums->back());
-}
-
-void MusicDb::removeNonExistingFilesCb(sqlite3_stmt* pStmt, void* pData)
+void MusicDb::getIntIdsCb(sqlite3_stmt* pStmt, void* pData)
 {
-    assert(sqlite3_column_count(pStmt) == 2);
-
-    vector<uint32_t>* pFiles = reinterpret_cast<vector<uint32_t>*>(pData);
-
-    string path;
-    getStringFromColumn(pStmt, 1, path);
+    assert(sqlite3_column_count(pStmt) == 1);
 
-    if (!fileops::pathExists(path))
-    {
-        pFiles->push_back(sqlite3_column_int(pStmt, 0));
-    }
+    vector<uint32_t>* pIds = reinterpret_cast<vector<uint32_t>*>(pData);
+    pIds->push_back(sqlite3_column_int(pStmt, 0));
 }
 
-void MusicDb::getAllAlbumIdsCb(sqlite3_stmt* pStmt, void* pData)
+void MusicDb::getIdsCb(sqlite3_stmt* pStmt, void* pData)
 {
     assert(sqlite3_column_count(pStmt) == 1);
 
-    set<uint32_t>* pAlbums = reinterpret_cast<set<uint32_t>*>(pData);
-    pAlbums->insert(sqlite3_column_int(pStmt, 0));
+    vector<ItemId>* pIds = reinterpret_cast<vector<ItemId>*>(pData);
+    pIds->push_back(ItemId(sqlite3_column_int64(pStmt, 0)));
 }
 
 void MusicDb::countCb(sqlite3_stmt* pStmt, void* pData)
@@ -997,14 +2256,6 @@ void MusicDb::countCb(sqlite3_stmt* pStmt, void* pData)
     *pCount = sqlite3_column_int(pStmt, 0);
 }
 
-void MusicDb::addResultCb(sqlite3_stmt* pStmt, void* pData)
-{
-    assert(sqlite3_column_count(pStmt) == 1);
-
-    uint32_t* pSum = reinterpret_cast<uint32_t*>(pData);
-    *pSum += sqlite3_column_int(pStmt, 0);
-}
-
 int32_t MusicDb::busyCb(void* pData, int32_t retries)
 {
     log::debug("DB busy: attempt %d", retries);
@@ -20,9 +20,18 @@
 #include <string>
 #include <vector>
 #include <mutex>
+#include <map>
+#include <unordered_map>
+#include <thread>
+#include <atomic>
+#include <functional>
 
 #include "utils/types.h"
 #include "utils/subscriber.h"
+#include "statementcache.h"
+#include "queryprofiler.h"
+#include "idsampler.h"
+#include "itemid.h"
 
 
 struct sqlite3;
@@ -35,6 +44,7 @@ namespace Gejengel
 class Track;
 class Album;
 class AlbumArt;
+struct AlbumOrder;
 class ILibrarySubscriber;
 
 
@@ -48,11 +58,41 @@ public:
         UpToDate
     };
 
-    MusicDb(const std::string& dbFilepath);
+    // The database is opened in WAL mode, queries are served from up to
+    // maxReadConnections read-only connections (one per thread) so they do
+    // not have to wait for the writes of the scanner.
+    // 0 read connections performs everything on the writer connection.
+    MusicDb(const std::string& dbFilepath, uint32_t maxReadConnections = 4);
     ~MusicDb();
+
+    // closes the read connection of the calling thread, threads that exit
+    // call this so their connection can be used by other threads
+    void releaseReadConnection();
+    // Read connections on top of maxReadConnections for the threads of a
+    // scan, so the scan doesn't push the library requests to the writer.
+    // Nothing changes when the database has no read connections.
+    void addReadConnections(uint32_t count);
+    void removeReadConnections(uint32_t count);
     
     void setSubscriber(ILibrarySubscriber& subscriber);
 
+    // Writes between beginBatch and commitBatch are performed in a single
+    // transaction, subscribers are notified once the transaction is committed
+    void beginBatch();
+    void commitBatch();
+    // discards the writes and notifications of the batch, also after a
+    // failed commit, does nothing when no batch is active
+    void rollbackBatch();
+    bool isBatchActive();
+
+    // Loading a large number of tracks in an empty database: the indexes the
+    // scanner doesn't need are dropped, durability is turned off and without
+    // read connections the database is locked exclusively.
+    // endBulkLoad rebuilds the indexes and restores the normal settings.
+    void beginBulkLoad();
+    void endBulkLoad();
+    bool isBulkLoadActive();
+
     uint32_t getTrackCount();
     uint32_t getAlbumCount();
 
@@ -63,63 +103,153 @@ public:
 
     bool trackExists(const std::string& filepath);
     TrackStatus getTrackStatus(const std::string& filepath, uint32_t modifiedTime);
-    void albumExists(const std::string& name, std::string& id);
+    void albumExists(const std::string& name, ItemId& id);
+    void albumExists(const std::string& name, const std::string& albumArtist, ItemId& id);
 
-    bool getTrack(const std::string& id, Track& track);
+    bool getTrack(const ItemId& id, Track& track);
     bool getTrackWithPath(const std::string& filepath, Track& track);
-    bool getAlbum(const std::string& id, Album& album);
+    bool getAlbum(const ItemId& id, Album& album);
     bool getAlbumArt(const Album& album, AlbumArt& art);
-    void setAlbumArt(const std::string& albumId, const std::vector<uint8_t>& data);
+    void setAlbumArt(const ItemId& albumId, const std::vector<uint8_t>& data);
 
     void getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber);
     void getRandomAlbum(utils::ISubscriber<const Track&>& subscriber);
-    void getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
-    void getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
     void getAlbums(utils::ISubscriber<const Album&>& subscriber);
-    void removeTrack(const std::string& id);
-    void removeAlbum(const std::string& id);
+
+    // Sends at most pageSize albums that follow the cursor album in the given
+    // order, starting from the first album when the cursor is empty. The cursor
+    // is moved to the last album that was sent, so it can be passed for the next
+    // page. Returns false and calls finalItemReceived after the last page.
+    bool getAlbumPage(const AlbumOrder& order, Album& cursor, uint32_t pageSize, utils::ISubscriber<const Album&>& subscriber);
+    void removeTrack(const ItemId& id);
+    void removeAlbum(const ItemId& id);
 
     void removeNonExistingFiles();
+    // removes the tracks in the directory and its subdirectories
+    void removeDirectory(const std::string& path);
+
+    // The modification time and entry count of a directory when its files
+    // were last scanned. Only adding, removing or renaming entries changes
+    // them, the files of an unchanged directory don't need to be checked.
+    bool isDirectoryUnchanged(const std::string& path, uint32_t modifiedTime, uint32_t entryCount);
+    void setDirectoryFingerprint(const std::string& path, uint32_t modifiedTime, uint32_t entryCount);
     void removeNonExistingAlbums();
     void updateAlbumMetaData();
 
     void searchLibrary(const std::string& search, utils::ISubscriber<const Track&>& trackSubscriber, utils::ISubscriber<const Album&>& albumSubscriber);
     void clearDatabase();
 
+    StatementCache::Stats getStatementCacheStats();
+
+    // Refreshes the planner statistics and returns free pages to the file
+    // system, spending at most about timeBudgetInMs on the vacuum. Returns the
+    // number of pages that were reclaimed. Nothing is done while a batch or a
+    // bulk load is active.
+    uint32_t performMaintenance(uint32_t timeBudgetInMs);
+    // set after changes that leave the statistics outdated or pages unused
+    bool isMaintenanceDue();
+
+    // per statement timings of all connections, collected while profiling is enabled
+    void setQueryProfiling(bool enabled, uint32_t logIntervalInSec = 0);
+    std::vector<QueryProfiler::Entry> getQueryProfile();
+    std::string dumpQueryProfile();
+
 private:
+    class ReadConnection;
+    class Savepoint;
+
     typedef void (*QueryCallback)(sqlite3_stmt*, void*);
-    static void getIdCb(sqlite3_stmt* pStmt, void* pData);
-    static void getIdIntCb(sqlite3_stmt* pStmt, void* pData);
-    static void getTrackInfoCb(sqlite3_stmt* pStmt, void* pData);
-    static void getTrackModificationTimeCb(sqlite3_stmt* pStmt, void* pData);
-    static void getTracksCb(sqlite3_stmt* pStmt, void* pData);
+    static void getNameIdsCb(sqlite3_stmt* pStmt, void* pData);
     static void getAlbumCb(sqlite3_stmt* pStmt, void* pData);
     static void getAlbumArtCb(sqlite3_stmt* pStmt, void* pData);
-    static void getAlbumsCb(sqlite3_stmt* pStmt, void* pData);
-    static void getAlbumListCb(sqlite3_stmt* pStmt, void* pData);
-    static void getAllAlbumIdsCb(sqlite3_stmt* pStmt, void* pData);
-    static void removeNonExistingFilesCb(sqlite3_stmt* pStmt, void* pData);
+    static void getIdsCb(sqlite3_stmt* pStmt, void* pData);
+    static void getIntIdsCb(sqlite3_stmt* pStmt, void* pData);
     static void countCb(sqlite3_stmt* pStmt, void* pData);
-    static void addResultCb(sqlite3_stmt* pStmt, void* pData);
-    static void searchTracksCb(sqlite3_stmt* pStmt, void* pData);
 
     static int32_t busyCb(void* pData, int32_t retries);
 
-    void addArtistIfNotExists(const std::string& name, std::string& id);
-    void addGenreIfNotExists(const std::string& name, std::string& id);
+    typedef std::function<void(ILibrarySubscriber&)> Notification;
+    void notify(const Notification& notification);
+
+    typedef std::unordered_map<std::string, uint32_t> IdMap;
+
+    uint32_t addArtistIfNotExists(const std::string& name);
+    uint32_t addGenreIfNotExists(const std::string& name);
+    uint32_t addNameIfNotExists(IdMap& ids, const char* insertQuery, const std::string& name);
+    uint32_t addDirectoryIfNotExists(const std::string& path);
+    void removeUnusedDirectories();
+    void loadDirectoryIds();
+    uint32_t getAlbumId(const std::string& name);
+    void forgetAlbum(const ItemId& id);
+    void forgetAlbumName(const std::string& name, uint32_t albumId);
+    void loadIdCaches();
+
+    void migrateSchema();
+    uint32_t getSchemaVersion();
+    void setSchemaVersion(uint32_t version);
+    bool columnExists(const std::string& table, const std::string& column);
+    int32_t getPragma(const std::string& name);
 
-    void getIdFromTable(const std::string& table, const std::string& name, std::string& id);
-    uint32_t getIdFromTable(const std::string& table, const std::string& name);
     void createInitialDatabase();
-    uint32_t performQuery(sqlite3_stmt* pStmt, QueryCallback cb = nullptr, void* pData = nullptr, bool finalize = true);
-    sqlite3_stmt* createStatement(const char* query);
+    void createAlbumArtStore();
+    void createSearchIndex();
+    void createSearchTriggers();
+    void createAlbumIndexes();
+    void createTrackInfo();
+    void createTrackInfoTriggers();
+    void createAlbumArtistIndex();
+    void createDirectories();
+    void createDirectoryFingerprints();
+
+    uint32_t storeAlbumArt(const std::vector<uint8_t>& data);
+    void removeUnusedAlbumArt();
+    uint32_t performQuery(sqlite3_stmt* pStmt, QueryCallback cb = nullptr, void* pData = nullptr);
+    template <typename Query, typename Func>
+    uint32_t forEachRow(sqlite3_stmt* pStmt, Func func);
+    typedef StatementCache::Statement Statement;
+    Statement createStatement(const std::string& query);
+    Statement createStatement(sqlite3* pDb, const std::string& query);
+    sqlite3* openConnection(int32_t flags);
+    void closeConnection(sqlite3* pDb);
+    sqlite3* getReadConnection();
     void bindValue(sqlite3_stmt* pStmt, const std::string& value, int32_t index);
+    // binds an empty string as text instead of NULL
+    void bindText(sqlite3_stmt* pStmt, const std::string& value, int32_t index);
     void bindValue(sqlite3_stmt* pStmt, uint32_t value, int32_t index);
+    void bindInt64(sqlite3_stmt* pStmt, int64_t value, int32_t index);
+    void bindId(sqlite3_stmt* pStmt, uint32_t id, int32_t index);
+    void bindValue(sqlite3_stmt* pStmt, const ItemId& id, int32_t index);
     void bindValue(sqlite3_stmt* pStmt, const void* pData, uint32_t dataSize, int32_t index);
     
-    sqlite3*                m_pDb;
-    ILibrarySubscriber*     m_pSubscriber;
-    std::recursive_mutex    m_DbMutex;
+    std::string                         m_DbFilepath;
+    sqlite3*                            m_pDb;
+    StatementCache                      m_Statements;
+    QueryProfiler                       m_Profiler;
+    ILibrarySubscriber*                 m_pSubscriber;
+    std::recursive_mutex                m_DbMutex;
+    bool                                m_BatchActive;
+    std::atomic<std::thread::id>        m_BatchThread;
+    std::vector<Notification>           m_PendingNotifications;
+    uint32_t                            m_MaxReadConnections;
+    std::map<std::thread::id, sqlite3*> m_ReadConnections;
+    std::mutex                          m_ReadConnectionsMutex;
+    uint32_t                            m_ExtraReadConnections;
+    std::atomic<bool>                   m_BulkLoadActive;
+    std::atomic<bool>                   m_MaintenanceDue;
+    int32_t                             m_SynchronousMode;
+    int32_t                             m_CacheSize;
+
+    // name to id lookups of the scanner, protected by the db mutex
+    IdMap                                       m_ArtistIds;
+    IdMap                                       m_GenreIds;
+    IdMap                                       m_AlbumIds;
+    IdMap                                       m_DirectoryIds;
+    std::unordered_map<uint32_t, std::string>   m_AlbumNames;
+
+    IdSampler                                   m_TrackSampler;
+    IdSampler                                   m_AlbumSampler;
 };
 
 }
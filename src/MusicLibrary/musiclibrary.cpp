@@ -66,7 +66,7 @@ void MusicLibrary::newTrack(const Track& track)
     }
 }
 
-void MusicLibrary::deletedTrack(const std::string& id)
+void MusicLibrary::deletedTrack(const ItemId& id)
 {
     std::lock_guard<std::mutex> lock(m_SubscribersMutex);
     for (SubscriberIter iter = m_Subscribers.begin(); iter != m_Subscribers.end(); ++iter)
@@ -93,7 +93,7 @@ void MusicLibrary::newAlbum(const Album& album)
     }
 }
 
-void MusicLibrary::deletedAlbum(const std::string& id)
+void MusicLibrary::deletedAlbum(const ItemId& id)
 {
     std::lock_guard<std::mutex> lock(m_SubscribersMutex);
     for (SubscriberIter iter = m_Subscribers.begin(); iter != m_Subscribers.end(); ++iter)
@@ -102,6 +102,24 @@ void MusicLibrary::deletedAlbum(const std::string& id)
     }
 }
 
+void MusicLibrary::deletedTracks(const std::vector<ItemId>& ids)
+{
+    std::lock_guard<std::mutex> lock(m_SubscribersMutex);
+    for (SubscriberIter iter = m_Subscribers.begin(); iter != m_Subscribers.end(); ++iter)
+    {
+        (*iter)->deletedTracks(ids);
+    }
+}
+
+void MusicLibrary::deletedAlbums(const std::vector<ItemId>& ids)
+{
+    std::lock_guard<std::mutex> lock(m_SubscribersMutex);
+    for (SubscriberIter iter = m_Subscribers.begin(); iter != m_Subscribers.end(); ++iter)
+    {
+        (*iter)->deletedAlbums(ids);
+    }
+}
+
 void MusicLibrary::updatedAlbum(const Album& album)
 {   
     std::lock_guard<std::mutex> lock(m_SubscribersMutex);
@@ -30,6 +30,7 @@ namespace Gejengel
 
 class Track;
 class Album;
+struct AlbumOrder;
 class Settings;
 class LibrarySource;
 
@@ -42,20 +43,22 @@ public:
     virtual uint32_t getTrackCount() = 0;
     virtual uint32_t getAlbumCount() = 0;
 
-    virtual void getTrack(const std::string& id, Track& track) = 0;
-    virtual void getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber) = 0;
+    virtual void getTrack(const ItemId& id, Track& track) = 0;
+    virtual void getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber) = 0;
 
-    virtual void getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
-    virtual void getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
+    virtual void getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
+    virtual void getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
 
-    virtual void getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
-    virtual void getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
+    virtual void getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
+    virtual void getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber) = 0;
 
-    virtual void getAlbum(const std::string& albumId, Album& album) = 0;
-    virtual void getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber) = 0;
+    virtual void getAlbum(const ItemId& albumId, Album& album) = 0;
+    virtual void getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber) = 0;
 
     virtual void getAlbums(utils::ISubscriber<const Album&>& subscriber) = 0;
     virtual void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber) = 0;
+    // the albums are sent in pages in the given order if the library supports it
+    virtual void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber, const AlbumOrder& order) { getAlbumsAsync(subscriber); }
 
     virtual void getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber) = 0;
     virtual void getRandomTracksAsync(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber) = 0;
@@ -70,22 +73,30 @@ public:
 
     virtual void setSource(const LibrarySource& source) = 0;
 
+    // drops the asynchronous requests of the subscriber that have not started yet
+    void cancelRequests(utils::ISubscriber<const Track&>& subscriber)  { cancelPendingRequests(&subscriber); }
+    void cancelRequests(utils::ISubscriber<const Album&>& subscriber)  { cancelPendingRequests(&subscriber); }
+
     void addLibrarySubscriber(ILibrarySubscriber& subscriber);
     std::vector<ILibrarySubscriber*> getSubscribers();
     void clearSubscribers();
 
     void newTrack(const Track& track);
-    void deletedTrack(const std::string& id);
+    void deletedTrack(const ItemId& id);
     void updatedTrack(const Track& track);
     void newAlbum(const Album& album);
-    void deletedAlbum(const std::string& id);
+    void deletedAlbum(const ItemId& id);
     void updatedAlbum(const Album& album);
     void libraryCleared();
+    void deletedTracks(const std::vector<ItemId>& ids);
+    void deletedAlbums(const std::vector<ItemId>& ids);
 
 
 protected:
     typedef std::vector<ILibrarySubscriber*>::iterator SubscriberIter;
 
+    virtual void cancelPendingRequests(const void* pSubscriber) {}
+
     const Settings&                     m_Settings;
     std::vector<ILibrarySubscriber*>    m_Subscribers;
     std::mutex                          m_SubscribersMutex;
@@ -0,0 +1,252 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "queryprofiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include <sqlite3.h>
+
+#include "utils/log.h"
+
+using namespace std;
+using namespace utils;
+
+namespace Gejengel
+{
+
+QueryProfiler::QueryProfiler()
+: m_Enabled(false)
+, m_LogInterval(0)
+, m_LastLog(std::chrono::steady_clock::now())
+{
+}
+
+void QueryProfiler::attach(sqlite3* pDb)
+{
+    std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+    m_Connections.push_back(pDb);
+
+    if (m_Enabled)
+    {
+        installHook(pDb);
+    }
+}
+
+void QueryProfiler::detach(sqlite3* pDb)
+{
+    std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+    auto iter = std::find(m_Connections.begin(), m_Connections.end(), pDb);
+    if (iter != m_Connections.end())
+    {
+        removeHook(pDb);
+        m_Connections.erase(iter);
+    }
+}
+
+void QueryProfiler::setEnabled(bool enabled, uint32_t logIntervalInSec)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_StatsMutex);
+        m_LogInterval = logIntervalInSec;
+        m_LastLog = std::chrono::steady_clock::now();
+    }
+
+    std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+    if (m_Enabled == enabled)
+    {
+        return;
+    }
+
+    m_Enabled = enabled;
+    for (auto pDb : m_Connections)
+    {
+        if (enabled)
+        {
+            installHook(pDb);
+        }
+        else
+        {
+            removeHook(pDb);
+        }
+    }
+
+    log::info("Query profiling %s", enabled ? "enabled" : "disabled");
+}
+
+bool QueryProfiler::isEnabled()
+{
+    std::lock_guard<std::mutex> lock(m_ConnectionsMutex);
+    return m_Enabled;
+}
+
+void QueryProfiler::installHook(sqlite3* pDb)
+{
+    if (sqlite3_trace_v2(pDb, SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &QueryProfiler::traceCb, this) != SQLITE_OK)
+    {
+        log::warn("Failed to install the query profiler: %s", sqlite3_errmsg(pDb));
+    }
+}
+
+void QueryProfiler::removeHook(sqlite3* pDb)
+{
+    sqlite3_trace_v2(pDb, 0, nullptr, nullptr);
+}
+
+int QueryProfiler::traceCb(unsigned int type, void* pContext, void* pStatement, void* pExtra)
+{
+    QueryProfiler* pProfiler = reinterpret_cast<QueryProfiler*>(pContext);
+    sqlite3_stmt* pStmt = reinterpret_cast<sqlite3_stmt*>(pStatement);
+
+    if (type == SQLITE_TRACE_ROW)
+    {
+        pProfiler->onRow(pStmt);
+    }
+    else if (type == SQLITE_TRACE_PROFILE)
+    {
+        pProfiler->onProfile(pStmt, *reinterpret_cast<sqlite3_int64*>(pExtra));
+    }
+
+    return 0;
+}
+
+static const char* getStatementText(sqlite3_stmt* pStmt)
+{
+    // the statement text is the key, the parameter values are not part of it
+    const char* pSql = sqlite3_sql(pStmt);
+    return pSql ? pSql : "";
+}
+
+void QueryProfiler::onRow(sqlite3_stmt* pStmt)
+{
+    // the rows are not kept per statement handle until the profile event,
+    // sqlite does not report that event for every statement that returns rows
+    std::lock_guard<std::mutex> lock(m_StatsMutex);
+    ++m_Stats[getStatementText(pStmt)].rows;
+}
+
+void QueryProfiler::onProfile(sqlite3_stmt* pStmt, uint64_t nanoseconds)
+{
+    bool logReport = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_StatsMutex);
+
+        Stats& stats = m_Stats[getStatementText(pStmt)];
+
+        uint64_t microseconds = nanoseconds / 1000;
+        ++stats.calls;
+        stats.totalMicroseconds += microseconds;
+        stats.maxMicroseconds = std::max(stats.maxMicroseconds, microseconds);
+
+        uint32_t bucket = 0;
+        while (microseconds > 0 && bucket < BUCKET_COUNT - 1)
+        {
+            microseconds >>= 1;
+            ++bucket;
+        }
+        ++stats.buckets[bucket];
+
+        auto now = std::chrono::steady_clock::now();
+        if (m_LogInterval > 0 && now - m_LastLog >= std::chrono::seconds(m_LogInterval))
+        {
+            m_LastLog = now;
+            logReport = true;
+        }
+    }
+
+    // dump takes the lock itself
+    if (logReport)
+    {
+        log::info("Query profile:\n%s", dump());
+    }
+}
+
+uint64_t QueryProfiler::getPercentile(const Stats& stats, double percentile)
+{
+    uint64_t rank = static_cast<uint64_t>(std::ceil(stats.calls * percentile));
+    uint64_t count = 0;
+
+    for (uint32_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        count += stats.buckets[i];
+        if (count >= rank && count > 0)
+        {
+            // upper bound of the bucket, never more than the slowest call
+            uint64_t upperBound = i == 0 ? 0 : (1ULL << i) - 1;
+            return std::min(upperBound, stats.maxMicroseconds);
+        }
+    }
+
+    return stats.maxMicroseconds;
+}
+
+std::vector<QueryProfiler::Entry> QueryProfiler::getEntries()
+{
+    std::vector<Entry> entries;
+
+    {
+        std::lock_guard<std::mutex> lock(m_StatsMutex);
+        for (auto& pair : m_Stats)
+        {
+            Entry entry;
+            entry.sql               = pair.first;
+            entry.calls             = pair.second.calls;
+            entry.rows              = pair.second.rows;
+            entry.totalMicroseconds = pair.second.totalMicroseconds;
+            entry.maxMicroseconds   = pair.second.maxMicroseconds;
+            entry.p50Microseconds   = getPercentile(pair.second, 0.50);
+            entry.p99Microseconds   = getPercentile(pair.second, 0.99);
+            entries.push_back(entry);
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [] (const Entry& lhs, const Entry& rhs) {
+        return lhs.totalMicroseconds > rhs.totalMicroseconds;
+    });
+
+    return entries;
+}
+
+std::string QueryProfiler::dump()
+{
+    std::ostringstream ss;
+    ss << setw(10) << "calls" << setw(12) << "total ms" << setw(10) << "p50 us" << setw(10) << "p99 us"
+       << setw(10) << "max us" << setw(10) << "rows" << "  statement" << endl;
+
+    for (auto& entry : getEntries())
+    {
+        ss << setw(10) << entry.calls
+           << setw(12) << entry.totalMicroseconds / 1000
+           << setw(10) << entry.p50Microseconds
+           << setw(10) << entry.p99Microseconds
+           << setw(10) << entry.maxMicroseconds
+           << setw(10) << entry.rows
+           << "  " << entry.sql << endl;
+    }
+
+    return ss.str();
+}
+
+void QueryProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(m_StatsMutex);
+    m_Stats.clear();
+}
+
+}
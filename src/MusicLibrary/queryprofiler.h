@@ -0,0 +1,103 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef QUERY_PROFILER_H
+#define QUERY_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+
+#include "utils/types.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace Gejengel
+{
+
+// Collects the execution times of the statements of the attached connections
+// through the sqlite trace hooks. The hooks are only installed while the
+// profiler is enabled, a disabled profiler costs nothing.
+class QueryProfiler
+{
+public:
+    struct Entry
+    {
+        Entry() : calls(0), rows(0), totalMicroseconds(0), p50Microseconds(0), p99Microseconds(0), maxMicroseconds(0) {}
+
+        std::string     sql;
+        uint64_t        calls;
+        uint64_t        rows;
+        uint64_t        totalMicroseconds;
+        uint64_t        p50Microseconds;
+        uint64_t        p99Microseconds;
+        uint64_t        maxMicroseconds;
+    };
+
+    QueryProfiler();
+
+    void attach(sqlite3* pDb);
+    void detach(sqlite3* pDb);
+
+    // a log interval of 0 disables the periodic log output
+    void setEnabled(bool enabled, uint32_t logIntervalInSec = 0);
+    bool isEnabled();
+
+    // sorted on the total time, the most expensive statement first
+    std::vector<Entry> getEntries();
+    std::string dump();
+    void reset();
+
+private:
+    // latencies are counted in power of two buckets of microseconds
+    static const uint32_t BUCKET_COUNT = 32;
+
+    struct Stats
+    {
+        Stats() : calls(0), rows(0), totalMicroseconds(0), maxMicroseconds(0), buckets() {}
+
+        uint64_t        calls;
+        uint64_t        rows;
+        uint64_t        totalMicroseconds;
+        uint64_t        maxMicroseconds;
+        uint64_t        buckets[BUCKET_COUNT];
+    };
+
+    static int traceCb(unsigned int type, void* pContext, void* pStatement, void* pExtra);
+    static uint64_t getPercentile(const Stats& stats, double percentile);
+    void installHook(sqlite3* pDb);
+    void removeHook(sqlite3* pDb);
+    void onRow(sqlite3_stmt* pStmt);
+    void onProfile(sqlite3_stmt* pStmt, uint64_t nanoseconds);
+
+    // the hooks run with the mutex of the connection locked, so the
+    // connections mutex is never taken from within a hook
+    bool                                            m_Enabled;
+    std::vector<sqlite3*>                           m_Connections;
+    std::mutex                                      m_ConnectionsMutex;
+
+    uint32_t                                        m_LogInterval;
+    std::chrono::steady_clock::time_point           m_LastLog;
+    std::unordered_map<std::string, Stats>          m_Stats;
+    std::mutex                                      m_StatsMutex;
+};
+
+}
+
+#endif
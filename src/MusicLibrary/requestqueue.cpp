@@ -0,0 +1,208 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "requestqueue.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "utils/log.h"
+
+using namespace utils;
+
+namespace Gejengel
+{
+
+RequestQueue::RequestQueue(uint32_t workerCount)
+: m_LastActivity(std::chrono::steady_clock::now())
+, m_Destroy(false)
+{
+    for (uint32_t i = 0; i < std::max(workerCount, 1u); ++i)
+    {
+        m_Workers.push_back(std::thread(&RequestQueue::workerLoop, this));
+    }
+}
+
+RequestQueue::~RequestQueue()
+{
+    shutdown();
+}
+
+void RequestQueue::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Destroy = true;
+        m_Requests.clear();
+    }
+
+    m_Condition.notify_all();
+
+    for (auto& worker : m_Workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+void RequestQueue::post(Priority priority, const void* pOwner, const Request& request)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (m_Destroy)
+        {
+            // e.g. the next page of a listing that was running during the shutdown
+            return;
+        }
+
+        PendingRequest pending;
+        pending.priority    = priority;
+        pending.pOwner      = pOwner;
+        pending.request     = request;
+        m_Requests.push_back(pending);
+    }
+
+    m_Condition.notify_one();
+}
+
+uint32_t RequestQueue::cancel(const void* pOwner)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint32_t cancelled = 0;
+    for (auto iter = m_Requests.begin(); iter != m_Requests.end();)
+    {
+        if (iter->pOwner == pOwner)
+        {
+            iter = m_Requests.erase(iter);
+            ++cancelled;
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    return cancelled;
+}
+
+void RequestQueue::cancelAll()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Requests.clear();
+}
+
+size_t RequestQueue::getPendingCount()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Requests.size();
+}
+
+std::chrono::steady_clock::duration RequestQueue::getIdleTime()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_Requests.empty() || !m_RunningOwners.empty())
+    {
+        return std::chrono::steady_clock::duration::zero();
+    }
+
+    return std::chrono::steady_clock::now() - m_LastActivity;
+}
+
+bool RequestQueue::isRunning(const void* pOwner) const
+{
+    return std::find(m_RunningOwners.begin(), m_RunningOwners.end(), pOwner) != m_RunningOwners.end();
+}
+
+bool RequestQueue::findNextRequest(RequestIter& next)
+{
+    // the list is in posting order, so only the first request of an owner is a
+    // candidate, its later requests have to wait for it
+    std::vector<const void*> seenOwners;
+    bool found = false;
+
+    for (auto iter = m_Requests.begin(); iter != m_Requests.end(); ++iter)
+    {
+        if (std::find(seenOwners.begin(), seenOwners.end(), iter->pOwner) != seenOwners.end())
+        {
+            continue;
+        }
+
+        seenOwners.push_back(iter->pOwner);
+        if (isRunning(iter->pOwner))
+        {
+            continue;
+        }
+
+        if (!found || iter->priority < next->priority)
+        {
+            next = iter;
+            found = true;
+
+            if (next->priority == High)
+            {
+                break;
+            }
+        }
+    }
+
+    return found;
+}
+
+void RequestQueue::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    for (;;)
+    {
+        RequestIter next;
+        while (!m_Destroy && !findNextRequest(next))
+        {
+            m_Condition.wait(lock);
+        }
+
+        if (m_Destroy)
+        {
+            return;
+        }
+
+        const void* pOwner = next->pOwner;
+        Request request = std::move(next->request);
+        m_Requests.erase(next);
+        m_RunningOwners.push_back(pOwner);
+
+        lock.unlock();
+        try
+        {
+            request();
+        }
+        catch (std::exception& e)
+        {
+            log::error("Library request failed: %s", e.what());
+        }
+        lock.lock();
+
+        m_RunningOwners.erase(std::find(m_RunningOwners.begin(), m_RunningOwners.end(), pOwner));
+        m_LastActivity = std::chrono::steady_clock::now();
+
+        // requests of this owner could have been waiting for this one
+        m_Condition.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef REQUEST_QUEUE_H
+#define REQUEST_QUEUE_H
+
+#include <list>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+
+#include "utils/types.h"
+
+namespace Gejengel
+{
+
+// Runs requests on a pool of worker threads. Pending requests with a higher
+// priority are started first, the requests of the same owner (typically the
+// subscriber that receives the results) are executed one at a time in the
+// order they were posted.
+class RequestQueue
+{
+public:
+    enum Priority
+    {
+        High,
+        Normal,
+        Low
+    };
+
+    typedef std::function<void()> Request;
+
+    RequestQueue(uint32_t workerCount);
+    ~RequestQueue();
+
+    void post(Priority priority, const void* pOwner, const Request& request);
+
+    // removes the pending requests of the owner, a request that is
+    // already running still finishes
+    uint32_t cancel(const void* pOwner);
+    void cancelAll();
+
+    // drops the pending requests and waits for the running ones, requests
+    // posted afterwards are ignored
+    void shutdown();
+
+    size_t getPendingCount();
+
+    // time since the last request finished, zero while requests are pending or running
+    std::chrono::steady_clock::duration getIdleTime();
+
+private:
+    struct PendingRequest
+    {
+        Priority        priority;
+        const void*     pOwner;
+        Request         request;
+    };
+
+    typedef std::list<PendingRequest>::iterator RequestIter;
+
+    bool findNextRequest(RequestIter& next);
+    bool isRunning(const void* pOwner) const;
+    void workerLoop();
+
+    std::list<PendingRequest>           m_Requests;
+    std::vector<const void*>            m_RunningOwners;
+    std::vector<std::thread>            m_Workers;
+    std::mutex                          m_Mutex;
+    std::condition_variable             m_Condition;
+    std::chrono::steady_clock::time_point m_LastActivity;
+    bool                                m_Destroy;
+};
+
+}
+
+#endif
@@ -0,0 +1,247 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef ROW_CURSOR_H
+#define ROW_CURSOR_H
+
+#include <string>
+#include <cstring>
+#include <cassert>
+#include <sqlite3.h>
+
+#include "utils/types.h"
+
+// Declares a column that can be used in a query projection
+#define SQL_COLUMN(Tag, ValueType, Expression)                          \
+    struct Tag                                                          \
+    {                                                                   \
+        typedef ValueType Type;                                         \
+        static const char* name() { return Expression; }               \
+    }
+
+namespace Gejengel
+{
+namespace sql
+{
+
+// Text of a column in the current row, it points into the buffer of sqlite
+// and is only valid until the statement moves to the next row
+class TextRef
+{
+public:
+    TextRef()
+    : m_pData("")
+    , m_Size(0)
+    {
+    }
+
+    TextRef(const char* pData, size_t size)
+    : m_pData(pData ? pData : "")
+    , m_Size(size)
+    {
+    }
+
+    const char* data() const    { return m_pData; }
+    size_t size() const         { return m_Size; }
+    bool empty() const          { return m_Size == 0; }
+
+    std::string str() const
+    {
+        return std::string(m_pData, m_Size);
+    }
+
+    // reuses the capacity of the target string
+    void assignTo(std::string& str) const
+    {
+        str.assign(m_pData, m_Size);
+    }
+
+    bool operator==(const TextRef& other) const
+    {
+        return m_Size == other.m_Size && memcmp(m_pData, other.m_pData, m_Size) == 0;
+    }
+
+    bool operator!=(const TextRef& other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    const char* m_pData;
+    size_t      m_Size;
+};
+
+// Blob of a column in the current row, same lifetime as TextRef
+class BlobRef
+{
+public:
+    BlobRef(const void* pData, size_t size)
+    : m_pData(reinterpret_cast<const uint8_t*>(pData))
+    , m_Size(size)
+    {
+    }
+
+    const uint8_t* data() const { return m_pData; }
+    size_t size() const         { return m_Size; }
+    bool empty() const          { return m_Size == 0; }
+
+    bool equals(const void* pData, size_t size) const
+    {
+        return m_Size == size && (size == 0 || memcmp(m_pData, pData, size) == 0);
+    }
+
+private:
+    const uint8_t*  m_pData;
+    size_t          m_Size;
+};
+
+template <typename T>
+struct ColumnValue;
+
+template <>
+struct ColumnValue<int32_t>
+{
+    static int32_t get(sqlite3_stmt* pStmt, int column) { return sqlite3_column_int(pStmt, column); }
+};
+
+template <>
+struct ColumnValue<uint32_t>
+{
+    static uint32_t get(sqlite3_stmt* pStmt, int column) { return static_cast<uint32_t>(sqlite3_column_int64(pStmt, column)); }
+};
+
+template <>
+struct ColumnValue<int64_t>
+{
+    static int64_t get(sqlite3_stmt* pStmt, int column) { return sqlite3_column_int64(pStmt, column); }
+};
+
+template <>
+struct ColumnValue<TextRef>
+{
+    static TextRef get(sqlite3_stmt* pStmt, int column)
+    {
+        // the text has to be fetched before the size, the conversion can change it
+        const char* pText = reinterpret_cast<const char*>(sqlite3_column_text(pStmt, column));
+        return TextRef(pText, sqlite3_column_bytes(pStmt, column));
+    }
+};
+
+template <>
+struct ColumnValue<BlobRef>
+{
+    static BlobRef get(sqlite3_stmt* pStmt, int column)
+    {
+        const void* pData = sqlite3_column_blob(pStmt, column);
+        return BlobRef(pData, sqlite3_column_bytes(pStmt, column));
+    }
+};
+
+// Position of a column in the projection, fails to compile if it is not part of it
+template <typename Column, typename... Columns>
+struct ColumnIndex;
+
+template <typename Column, typename... Rest>
+struct ColumnIndex<Column, Column, Rest...>
+{
+    enum { value = 0 };
+};
+
+template <typename Column, typename First, typename... Rest>
+struct ColumnIndex<Column, First, Rest...>
+{
+    enum { value = 1 + ColumnIndex<Column, Rest...>::value };
+};
+
+template <typename... Columns>
+struct ColumnList;
+
+template <>
+struct ColumnList<>
+{
+    static void append(std::string&) {}
+};
+
+template <typename First, typename... Rest>
+struct ColumnList<First, Rest...>
+{
+    static void append(std::string& list)
+    {
+        if (!list.empty())
+        {
+            list += ", ";
+        }
+
+        list += First::name();
+        ColumnList<Rest...>::append(list);
+    }
+};
+
+// Typed access to the current row of a statement, the columns are
+// addressed by their tag instead of by index
+template <typename... Columns>
+class Row
+{
+public:
+    explicit Row(sqlite3_stmt* pStmt)
+    : m_pStmt(pStmt)
+    {
+        assert(sqlite3_column_count(pStmt) == sizeof...(Columns));
+    }
+
+    template <typename Column>
+    typename Column::Type get() const
+    {
+        return ColumnValue<typename Column::Type>::get(m_pStmt, ColumnIndex<Column, Columns...>::value);
+    }
+
+    template <typename Column>
+    bool isNull() const
+    {
+        return sqlite3_column_type(m_pStmt, ColumnIndex<Column, Columns...>::value) == SQLITE_NULL;
+    }
+
+private:
+    sqlite3_stmt*   m_pStmt;
+};
+
+// A query with a projection that is fixed at compile time
+template <typename... Columns>
+class Query
+{
+public:
+    typedef sql::Row<Columns...> RowType;
+
+    // the select statement for the projection followed by the given clauses
+    static std::string text(const std::string& clauses)
+    {
+        std::string columns;
+        ColumnList<Columns...>::append(columns);
+        return "SELECT " + columns + " " + clauses;
+    }
+
+    // query callback that passes every row to the function pointed to by pData
+    template <typename Func>
+    static void rowCallback(sqlite3_stmt* pStmt, void* pData)
+    {
+        (*reinterpret_cast<Func*>(pData))(RowType(pStmt));
+    }
+};
+
+}
+}
+
+#endif
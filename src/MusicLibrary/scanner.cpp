@@ -18,12 +18,10 @@
 
 #include <cassert>
 #include <ctime>
+#include <algorithm>
 
 #include "config.h"
-#include "track.h"
 #include "album.h"
-#include "albumart.h"
-#include "musicdb.h"
 #include "utils/stringoperations.h"
 #include "utils/log.h"
 #include "subscribers.h"
@@ -41,14 +39,37 @@ namespace Gejengel
 {
     
 static constexpr int32_t ALBUM_ART_DB_SIZE = 96;
+static constexpr uint32_t BATCH_FILE_COUNT = 500;
+static constexpr uint32_t BATCH_DURATION_MS = 2000;
+static constexpr uint32_t BULK_LOAD_BATCH_FILE_COUNT = 10000;
+static constexpr uint32_t BULK_LOAD_BATCH_DURATION_MS = 15000;
+static constexpr size_t PATH_QUEUE_SIZE = 1024;
+// the items carry the embedded album art
+static constexpr size_t ITEM_QUEUE_SIZE = 64;
+
+// albums with the same title are told apart by their album artist
+static std::string getAlbumKey(const Track& track)
+{
+    return track.album + '\n' + track.albumArtist;
+}
 
-Scanner::Scanner(MusicDb& db, IScanSubscriber& subscriber, const std::vector<std::string>& albumArtFilenames)
+Scanner::Scanner(MusicDb& db, IScanSubscriber& subscriber, const std::vector<std::string>& albumArtFilenames, uint32_t workerCount)
 : m_LibraryDb(db)
 , m_ScanSubscriber(subscriber)
 , m_ScannedFiles(0)
+, m_BatchFiles(0)
 , m_AlbumArtFilenames(albumArtFilenames)
+, m_WorkerCount(workerCount > 0 ? workerCount : std::max(1u, std::thread::hardware_concurrency()))
 , m_InitialScan(false)
 , m_Stop(false)
+, m_Paths(PATH_QUEUE_SIZE)
+, m_TaggedItems(ITEM_QUEUE_SIZE)
+, m_Items(ITEM_QUEUE_SIZE)
+, m_RunningTagWorkers(0)
+, m_SkippedFiles(0)
+, m_FoundFiles(0)
+, m_WalkFinished(false)
+, m_EstimatedFiles(0)
 {
 }
 
@@ -59,18 +80,19 @@ Scanner::~Scanner()
 
 void Scanner::performScan(const string& libraryPath)
 {
-	m_Stop = false;
-	
 #ifdef ENABLE_DEBUG
     time_t startTime = time(nullptr);
-    log::debug("Starting library scan in: %s", libraryPath);
+    log::debug("Starting library scan in: %s (%d tag readers)", libraryPath, m_WorkerCount);
 #endif
 
-    m_InitialScan = m_LibraryDb.getTrackCount() == 0;
-    m_ScannedFiles = 0;
+    // the library is walked once, until the walker is done the files of
+    // the previous scan are the estimate of the total
+    m_EstimatedFiles = m_LibraryDb.getTrackCount();
+    m_InitialScan = m_EstimatedFiles == 0;
+    m_ScanSubscriber.scanStart(m_EstimatedFiles);
+
+    runPipeline(vector<string>(1, libraryPath), vector<string>());
 
-    m_ScanSubscriber.scanStart(countFilesInDirectory(libraryPath));
-    scan(libraryPath);
     m_ScanSubscriber.scanFinish();
 
 #ifdef ENABLE_DEBUG
@@ -78,55 +100,283 @@ void Scanner::performScan(const string& libraryPath)
 	{
 		log::debug("Scan aborted");
 	}
-    log::debug("Library scan took %d seconds. Scanned %d files.", time(nullptr) - startTime, m_ScannedFiles);
+    log::debug("Library scan took %d seconds. Scanned %d files, skipped %d files in unchanged directories.", time(nullptr) - startTime, m_ScannedFiles.load(), m_SkippedFiles.load());
 #endif
 }
 
-void Scanner::scan(const std::string& dir)
+// The files are checked even if their directory is unchanged, a file that
+// was written in place doesn't change its directory
+void Scanner::scanChanges(const vector<string>& directories, const vector<string>& files)
+{
+    m_InitialScan = false;
+    m_EstimatedFiles = 0;
+    runPipeline(directories, files);
+
+    log::debug("Scanned %d changed files", m_ScannedFiles.load());
+}
+
+void Scanner::runPipeline(const vector<string>& directories, const vector<string>& files)
 {
+    m_ScannedFiles = 0;
+
+    m_Paths.reset();
+    m_TaggedItems.reset();
+    m_Items.reset();
+    m_ArtAlbums.clear();
+    m_PendingAlbums.clear();
+    m_WalkError = nullptr;
+    m_RunningTagWorkers = m_WorkerCount;
+    m_SkippedFiles = 0;
+    m_FoundFiles = 0;
+    m_WalkFinished = false;
+    m_PendingDirectories.clear();
+
+    // the walker, the tag readers, the art thread and the writer each read
+    // on a connection of their own
+    uint32_t readConnections = m_WorkerCount + 3;
+    m_LibraryDb.addReadConnections(readConnections);
+
+    vector<std::thread> threads;
+    threads.push_back(std::thread(&Scanner::walkerThread, this, std::cref(directories), std::cref(files)));
+    for (uint32_t i = 0; i < m_WorkerCount; ++i)
+    {
+        threads.push_back(std::thread(&Scanner::tagThread, this));
+    }
+    threads.push_back(std::thread(&Scanner::artThread, this));
+
+    auto joinThreads = [&] () {
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        m_LibraryDb.removeReadConnections(readConnections);
+    };
+
+    try
+    {
+        if (m_InitialScan)
+        {
+            m_LibraryDb.beginBulkLoad();
+        }
+
+        m_BatchFiles = 0;
+        m_BatchStart = std::chrono::steady_clock::now();
+        m_LibraryDb.beginBatch();
+
+        // a cancelled scan keeps the files that were scanned so far
+        writeItems();
+        writeAlbums();
+        m_LibraryDb.commitBatch();
+    }
+    catch (...)
+    {
+        cancel();
+        joinThreads();
+        m_PendingAlbums.clear();
+
+        // the failed batch is discarded, the batches that were committed
+        // before it are kept
+        try
+        {
+            m_LibraryDb.rollbackBatch();
+            if (m_InitialScan && m_LibraryDb.isBulkLoadActive())
+            {
+                m_LibraryDb.endBulkLoad();
+            }
+        }
+        catch (std::exception& e)
+        {
+            log::error("Failed to roll back the scan: %s", e.what());
+        }
+        throw;
+    }
+
+    joinThreads();
+
+    if (m_InitialScan)
+    {
+        m_LibraryDb.endBulkLoad();
+    }
+
+    if (m_WalkError)
+    {
+        std::rethrow_exception(m_WalkError);
+    }
+}
+
+void Scanner::cancel()
+{
+	m_Stop = true;
+
+    // wakes up the stages that wait for each other
+    m_Paths.close();
+    m_TaggedItems.close();
+    m_Items.close();
+}
+
+// The walker runs ahead of the writer, the number of files it found is exact
+// once it is finished
+uint32_t Scanner::getEstimatedFileCount(uint32_t scannedFiles)
+{
+    uint32_t estimate = m_FoundFiles;
+    if (!m_WalkFinished)
+    {
+        estimate = std::max(estimate, m_EstimatedFiles);
+    }
+
+    return std::max(estimate, scannedFiles);
+}
+
+void Scanner::reportProgress()
+{
+    std::lock_guard<std::mutex> lock(m_ProgressMutex);
+    uint32_t scannedFiles = m_ScannedFiles + m_SkippedFiles;
+    m_ScanSubscriber.scanUpdate(scannedFiles, getEstimatedFileCount(scannedFiles));
+}
+
+void Scanner::walkerThread(const vector<string>& directories, const vector<string>& files)
+{
+    try
+    {
+        for (auto& dir : directories)
+        {
+            walk(dir);
+        }
+
+        // single files don't belong to a pending directory, their directory
+        // is checked again on the next full scan
+        m_FoundFiles += files.size();
+        for (auto& file : files)
+        {
+            ScanItem item;
+            item.track.filepath = file;
+            if (m_Stop || !m_Paths.push(std::move(item)))
+            {
+                break;
+            }
+        }
+    }
+    catch (...)
+    {
+        m_WalkError = std::current_exception();
+    }
+
+    m_LibraryDb.releaseReadConnection();
+    m_WalkFinished = true;
+    m_Paths.close();
+}
+
+// Only adding, removing or renaming its entries changes the modification time
+// of a directory, so the files of an unchanged directory are not checked.
+// Changes deeper in the tree don't show in the parent, the subdirectories are
+// always visited.
+void Scanner::walk(const std::string& dir)
+{
+    vector<string> files;
+    vector<string> subdirs;
+    uint32_t entryCount = 0;
+
     for (auto& entry : Directory(dir))
     {
         if (m_Stop)
         {
-            break;
+            return;
         }
-        
+
+        ++entryCount;
         if (entry.type() == FileSystemEntryType::Directory)
         {
-            scan(entry.path());
+            subdirs.push_back(entry.path());
         }
         else if (entry.type() == FileSystemEntryType::File)
         {
-            try
+            files.push_back(entry.path());
+        }
+    }
+
+    m_FoundFiles += files.size();
+
+    if (!files.empty())
+    {
+        uint32_t modifiedTime = static_cast<uint32_t>(getFileInfo(dir).modifyTime);
+        if (m_LibraryDb.isDirectoryUnchanged(dir, modifiedTime, entryCount))
+        {
+            // a rescan without changes only reaches the writer at the end
+            m_SkippedFiles += files.size();
+            reportProgress();
+        }
+        else
+        {
             {
-                onFile(entry.path());
+                // the fingerprint is stored once the writer has written all the files
+                std::lock_guard<std::mutex> lock(m_PendingDirectoriesMutex);
+                PendingDirectory pending = { files.size(), modifiedTime, entryCount };
+                m_PendingDirectories[dir] = pending;
             }
-            catch (std::exception& e)
+
+            for (auto& file : files)
             {
-                log::debug("Ignored file: %s", e.what());
+                ScanItem item;
+                item.track.filepath = file;
+                item.directory = dir;
+                if (!m_Paths.push(std::move(item)))
+                {
+                    return;
+                }
             }
         }
     }
+
+    for (auto& subdir : subdirs)
+    {
+        walk(subdir);
+    }
 }
 
-void Scanner::cancel()
+void Scanner::tagThread()
 {
-	m_Stop = true;
+    ScanItem item;
+    while (!m_Stop && m_Paths.pop(item))
+    {
+        try
+        {
+            readTrack(item);
+        }
+        catch (std::exception& e)
+        {
+            // still passed on, the writer counts the scanned files
+            log::debug("Ignored file: %s", e.what());
+            item.status = MusicDb::UpToDate;
+        }
+
+        if (!m_TaggedItems.push(std::move(item)))
+        {
+            break;
+        }
+    }
+
+    m_LibraryDb.releaseReadConnection();
+
+    // the last worker tells the art thread that no more items will follow
+    if (--m_RunningTagWorkers == 0)
+    {
+        m_TaggedItems.close();
+    }
 }
 
-void Scanner::onFile(const string& filepath)
+void Scanner::readTrack(ScanItem& item)
 {
+    Track& track = item.track;
+    const string& filepath = track.filepath;
     auto info = getFileInfo(filepath);
     
-    Track track;
-    track.filepath      = filepath;
     track.fileSize      = info.sizeInBytes;
     track.modifiedTime  = info.modifyTime;
 
-    m_ScanSubscriber.scanUpdate(++m_ScannedFiles);
-
-    MusicDb::TrackStatus status = m_LibraryDb.getTrackStatus(filepath, track.modifiedTime);
-    if (status == MusicDb::UpToDate)
+    // every file is visited once, the committed state is all the worker needs
+    item.status = m_LibraryDb.getTrackStatus(filepath, track.modifiedTime);
+    if (item.status == MusicDb::UpToDate)
     {
         return;
     }
@@ -150,91 +400,282 @@ void Scanner::onFile(const string& filepath)
     if (track.artist.empty())   track.artist = UNKNOWN_ARTIST;
     if (track.title.empty())    track.title = UNKNOWN_TITLE;
 
-    Album album;
-    std::string albumId;
-    m_LibraryDb.albumExists(track.album, albumId);
-    if (!albumId.empty())
+    item.art.setAlbumArt(md.getAlbumArt());
+}
+
+void Scanner::artThread()
+{
+    ScanItem item;
+    while (!m_Stop && m_TaggedItems.pop(item))
     {
-        if (!m_LibraryDb.getAlbum(albumId, album))
+        if (item.status != MusicDb::UpToDate)
         {
-            assert(false && "The corresponding album could not be found in the database");
+            try
+            {
+                if (needsAlbumArt(item))
+                {
+                    processAlbumArt(item.track.filepath, item.art);
+                    if (!item.art.getData().empty())
+                    {
+                        m_ArtAlbums.insert(getAlbumKey(item.track));
+                    }
+                }
+                else
+                {
+                    item.art = AlbumArt();
+                }
+            }
+            catch (std::exception& e)
+            {
+                log::error("Failed to prepare album art: %s", e.what());
+                item.art = AlbumArt();
+            }
+        }
+
+        if (!m_Items.push(std::move(item)))
+        {
+            break;
         }
     }
 
-    if (albumId.empty() || ((!track.albumArtist.empty()) && track.albumArtist != album.artist))
+    m_LibraryDb.releaseReadConnection();
+    m_Items.close();
+}
+
+// The art of an album is prepared once per scan, the writer only stores the
+// art of an album that doesn't have any or when a track was updated
+bool Scanner::needsAlbumArt(const ScanItem& item)
+{
+    if (item.status == MusicDb::NeedsUpdate)
+    {
+        return true;
+    }
+
+    if (m_ArtAlbums.find(getAlbumKey(item.track)) != m_ArtAlbums.end())
+    {
+        return false;
+    }
+
+    Album album;
+    m_LibraryDb.albumExists(item.track.album, item.track.albumArtist, album.id);
+    if (album.id.empty())
     {
-        album.title         = track.album;
-        album.artist        = track.albumArtist.empty() ? track.artist : track.albumArtist;
-        album.year          = track.year;
-        album.genre         = track.genre;
-        album.durationInSec = track.durationInSec;
-        album.dateAdded     = m_InitialScan ? track.modifiedTime : time(nullptr);
-
-        AlbumArt art(albumId);
-        art.setAlbumArt(md.getAlbumArt());
-        processAlbumArt(filepath, art);
-
-        m_LibraryDb.addAlbum(album, art);
+        return true;
     }
-    else
+
+    AlbumArt art(album.id);
+    return !m_LibraryDb.getAlbumArt(album, art);
+}
+
+void Scanner::writeItems()
+{
+    ScanItem item;
+    while (!m_Stop && m_Items.pop(item))
     {
-        if (!track.albumArtist.empty())
+        ++m_ScannedFiles;
+        reportProgress();
+
+        // the changed files count once their track is written
+        if (item.status == MusicDb::UpToDate)
         {
-            //if a track has an album artist set, we trust it is the right one
-            if (track.albumArtist != album.artist)
-            {
-                album.artist = track.albumArtist;
-            }
+            fileWritten(item.directory);
         }
         else
         {
-            //if no album artist set and we detect different artists for an
-            //album, we set the album artist to VARIOUS_ARTISTS
-            if (album.artist != VARIOUS_ARTISTS && album.artist != track.artist)
+            try
             {
-                album.artist = VARIOUS_ARTISTS;
+                addToAlbum(item);
+            }
+            catch (std::exception& e)
+            {
+                log::debug("Ignored file: %s", e.what());
+                fileFailed(item.directory);
             }
         }
 
-        assert(album.id == albumId);
+        commitBatchIfNeeded();
+    }
+}
 
-        AlbumArt art(albumId);
+void Scanner::fileWritten(const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(m_PendingDirectoriesMutex);
+    auto iter = m_PendingDirectories.find(directory);
+    if (iter == m_PendingDirectories.end() || --iter->second.fileCount > 0)
+    {
+        return;
+    }
 
-        if (!m_LibraryDb.getAlbumArt(album, art) || status == MusicDb::NeedsUpdate)
-        {
-            art.setAlbumArt(md.getAlbumArt());
-            processAlbumArt(filepath, art);
+    // part of the batch that contains the tracks of the directory
+    m_LibraryDb.setDirectoryFingerprint(directory, iter->second.modifiedTime, iter->second.entryCount);
+    m_PendingDirectories.erase(iter);
+}
 
-            if (art.getDataSize() > 0)
-            {
-                m_LibraryDb.setAlbumArt(albumId, art.getData());
-            }
-        }
+// the directory is checked again on the next scan
+void Scanner::fileFailed(const std::string& directory)
+{
+    std::lock_guard<std::mutex> lock(m_PendingDirectoriesMutex);
+    m_PendingDirectories.erase(directory);
+}
+
+void Scanner::commitBatchIfNeeded()
+{
+    // bigger transactions during a bulk load, the new albums are
+    // published in larger steps
+    uint32_t maxFiles = m_InitialScan ? BULK_LOAD_BATCH_FILE_COUNT : BATCH_FILE_COUNT;
+    uint32_t maxDuration = m_InitialScan ? BULK_LOAD_BATCH_DURATION_MS : BATCH_DURATION_MS;
 
-        if (status == MusicDb::DoesntExist)
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_BatchStart);
+    if (++m_BatchFiles < maxFiles && elapsed.count() < maxDuration)
+    {
+        return;
+    }
+
+    writeAlbums();
+    m_LibraryDb.commitBatch();
+    m_LibraryDb.beginBatch();
+
+    m_BatchFiles = 0;
+    m_BatchStart = std::chrono::steady_clock::now();
+}
+
+// The tracks are collected per album, so the album is written once per batch
+// instead of once for every track
+void Scanner::addToAlbum(ScanItem& item)
+{
+    Track& track = item.track;
+
+    // like the database lookup, a track without an album artist joins any
+    // album with the same title
+    string key = getAlbumKey(track);
+    auto iter = m_PendingAlbums.lower_bound(key);
+    bool pendingAlbum = iter != m_PendingAlbums.end() && (iter->first == key || (track.albumArtist.empty() && iter->first.compare(0, key.size(), key) == 0));
+    if (!pendingAlbum)
+    {
+        iter = m_PendingAlbums.insert(iter, std::make_pair(key, PendingAlbum()));
+        PendingAlbum& pending = iter->second;
+        Album& album = pending.album;
+
+        ItemId albumId;
+        m_LibraryDb.albumExists(track.album, track.albumArtist, albumId);
+        if (!albumId.empty() && m_LibraryDb.getAlbum(albumId, album))
         {
-            album.durationInSec += track.durationInSec;
+            AlbumArt art(albumId);
+            pending.hasArt = m_LibraryDb.getAlbumArt(album, art);
         }
-
-        if (album.genre.empty())
+        else
         {
-            album.genre = track.genre;
+            album.title         = track.album;
+            album.artist        = track.albumArtist.empty() ? track.artist : track.albumArtist;
+            album.year          = track.year;
+            album.genre         = track.genre;
+            album.dateAdded     = m_InitialScan ? track.modifiedTime : time(nullptr);
         }
+    }
+
+    PendingAlbum& pending = iter->second;
+    Album& album = pending.album;
 
-        m_LibraryDb.updateAlbum(album);
+    if (!track.albumArtist.empty())
+    {
+        //if a track has an album artist set, we trust it is the right one
+        album.artist = track.albumArtist;
+    }
+    else if (album.artist != VARIOUS_ARTISTS && album.artist != track.artist)
+    {
+        //if no album artist set and we detect different artists for an
+        //album, we set the album artist to VARIOUS_ARTISTS
+        album.artist = VARIOUS_ARTISTS;
     }
 
-    track.albumId = album.id;
-    if (status == MusicDb::DoesntExist)
+    if (album.id.empty() || item.status == MusicDb::DoesntExist)
     {
-        log::debug("New track: %s %s", filepath, track.albumId);
-        m_LibraryDb.addTrack(track);
+        album.durationInSec += track.durationInSec;
     }
-    else if (status == MusicDb::NeedsUpdate)
+
+    if (album.genre.empty())
+    {
+        album.genre = track.genre;
+    }
+
+    album.discCount = std::max(album.discCount, track.discNr);
+
+    if (item.art.getDataSize() > 0 && (!pending.hasArt || item.status == MusicDb::NeedsUpdate))
+    {
+        pending.art = std::move(item.art);
+        pending.hasArt = true;
+    }
+
+    item.art = AlbumArt();
+    pending.items.push_back(std::move(item));
+}
+
+// Writes the albums that got tracks since the last commit with their final
+// artist, duration, genre and disc count, followed by their tracks. Called
+// before every commit so the tracks are part of the same transaction as the
+// fingerprints of their directories.
+void Scanner::writeAlbums()
+{
+    for (auto& entry : m_PendingAlbums)
     {
-        log::debug("Needs update: %s", filepath);
-        m_LibraryDb.updateTrack(track);
+        PendingAlbum& pending = entry.second;
+        Album& album = pending.album;
+
+        try
+        {
+            if (album.id.empty())
+            {
+                m_LibraryDb.addAlbum(album, pending.art);
+            }
+            else
+            {
+                if (pending.art.getDataSize() > 0)
+                {
+                    m_LibraryDb.setAlbumArt(album.id, pending.art.getData());
+                }
+
+                m_LibraryDb.updateAlbum(album);
+            }
+        }
+        catch (std::exception& e)
+        {
+            log::error("Failed to write album %s: %s", album.title, e.what());
+            for (auto& item : pending.items)
+            {
+                fileFailed(item.directory);
+            }
+            continue;
+        }
+
+        for (auto& item : pending.items)
+        {
+            Track& track = item.track;
+            track.albumId = album.id;
+
+            try
+            {
+                if (item.status == MusicDb::DoesntExist)
+                {
+                    log::debug("New track: %s %s", track.filepath, track.albumId);
+                    m_LibraryDb.addTrack(track);
+                }
+                else if (item.status == MusicDb::NeedsUpdate)
+                {
+                    log::debug("Needs update: %s", track.filepath);
+                    m_LibraryDb.updateTrack(track);
+                }
+
+                fileWritten(item.directory);
+            }
+            catch (std::exception& e)
+            {
+                log::debug("Ignored file: %s", e.what());
+                fileFailed(item.directory);
+            }
+        }
     }
+
+    m_PendingAlbums.clear();
 }
 
 void Scanner::processAlbumArt(const std::string& filepath, AlbumArt& art)
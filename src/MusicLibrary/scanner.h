@@ -19,40 +19,120 @@
 
 #include <string>
 #include <vector>
+#include <set>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <exception>
 
 #include "utils/fileoperations.h"
+#include "track.h"
+#include "album.h"
+#include "albumart.h"
+#include "musicdb.h"
+#include "boundedqueue.h"
 
 using namespace utils;
 
 namespace Gejengel
 {
 
-class Track;
-class Album;
-class AlbumArt;
-class MusicDb;
 class IScanSubscriber;
 
+// The scan is a pipeline: a walker thread lists the files, a pool of workers
+// reads their tags, a single thread prepares the album art and the thread
+// that calls performScan writes everything to the database.
 class Scanner
 {
 public:
-    Scanner(MusicDb& db, IScanSubscriber& subscriber, const std::vector<std::string>& albumArtFilenames);
+    // workerCount is the number of tag reading threads, 0 uses one per core
+    Scanner(MusicDb& db, IScanSubscriber& subscriber, const std::vector<std::string>& albumArtFilenames, uint32_t workerCount = 0);
     ~Scanner();
 
     void performScan(const std::string& libraryPath);
+    // only scans the given directories and files, used for the changes
+    // that are reported while the library is watched
+    void scanChanges(const std::vector<std::string>& directories, const std::vector<std::string>& files);
+    // also stops the scans that didn't start yet, a cancelled scanner
+    // isn't used again
     void cancel();
 
 private:
-    void scan(const std::string& dir);
-    void onFile(const std::string& filepath);
+    struct ScanItem
+    {
+        ScanItem() : status(MusicDb::UpToDate) {}
+
+        Track                   track;
+        MusicDb::TrackStatus    status;
+        AlbumArt                art;
+        std::string             directory;
+    };
+
+    // an album and the tracks that were found for it since the last commit
+    struct PendingAlbum
+    {
+        PendingAlbum() : hasArt(false) {}
+
+        Album                   album;
+        AlbumArt                art;
+        bool                    hasArt;
+        std::vector<ScanItem>   items;
+    };
+
+    // a directory of which not all files have been written yet
+    struct PendingDirectory
+    {
+        size_t                  fileCount;
+        uint32_t                modifiedTime;
+        uint32_t                entryCount;
+    };
+
+    void runPipeline(const std::vector<std::string>& directories, const std::vector<std::string>& files);
+    void walkerThread(const std::vector<std::string>& directories, const std::vector<std::string>& files);
+    void walk(const std::string& dir);
+    uint32_t getEstimatedFileCount(uint32_t scannedFiles);
+    void tagThread();
+    void readTrack(ScanItem& item);
+    void artThread();
+    bool needsAlbumArt(const ScanItem& item);
+    void writeItems();
+    void reportProgress();
+    void addToAlbum(ScanItem& item);
+    void writeAlbums();
+    void fileWritten(const std::string& directory);
+    void fileFailed(const std::string& directory);
+    void commitBatchIfNeeded();
     void processAlbumArt(const std::string& filepath, AlbumArt& art);
 
     MusicDb&                        m_LibraryDb;
     IScanSubscriber&                m_ScanSubscriber;
-    int32_t                         m_ScannedFiles;
+    std::atomic<uint32_t>           m_ScannedFiles;
+    uint32_t                        m_BatchFiles;
+    std::chrono::steady_clock::time_point m_BatchStart;
     std::vector<std::string>        m_AlbumArtFilenames;
+    uint32_t                        m_WorkerCount;
     bool                            m_InitialScan;
-    bool							m_Stop;
+    std::atomic<bool>               m_Stop;
+
+    BoundedQueue<ScanItem>          m_Paths;
+    BoundedQueue<ScanItem>          m_TaggedItems;
+    BoundedQueue<ScanItem>          m_Items;
+    std::atomic<uint32_t>           m_RunningTagWorkers;
+    std::exception_ptr              m_WalkError;
+    std::atomic<uint32_t>           m_SkippedFiles;
+    std::atomic<uint32_t>           m_FoundFiles;
+    std::atomic<bool>               m_WalkFinished;
+    uint32_t                        m_EstimatedFiles;
+    std::map<std::string, PendingDirectory> m_PendingDirectories;
+    std::mutex                      m_PendingDirectoriesMutex;
+    // the walker and the writer both report the progress
+    std::mutex                      m_ProgressMutex;
+    // albums that got their art during this scan, only used by the art thread
+    std::set<std::string>           m_ArtAlbums;
+    // the albums of the current batch by title and album artist, only used by the writer
+    std::map<std::string, PendingAlbum> m_PendingAlbums;
 };
 
 }
@@ -0,0 +1,176 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#include "statementcache.h"
+
+#include <stdexcept>
+#include <cassert>
+#include <sqlite3.h>
+
+#include "utils/log.h"
+
+using namespace std;
+using namespace utils;
+
+namespace Gejengel
+{
+
+StatementCache::Statement::Statement(Statement&& other)
+: m_pCache(other.m_pCache)
+, m_pStmt(other.m_pStmt)
+{
+    other.m_pStmt = nullptr;
+}
+
+StatementCache::Statement::~Statement()
+{
+    release();
+}
+
+StatementCache::Statement& StatementCache::Statement::operator=(Statement&& other)
+{
+    if (this != &other)
+    {
+        release();
+        m_pCache = other.m_pCache;
+        m_pStmt = other.m_pStmt;
+        other.m_pStmt = nullptr;
+    }
+
+    return *this;
+}
+
+void StatementCache::Statement::release()
+{
+    if (m_pStmt != nullptr)
+    {
+        m_pCache->release(m_pStmt);
+        m_pStmt = nullptr;
+    }
+}
+
+StatementCache::StatementCache()
+{
+}
+
+StatementCache::~StatementCache()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto& pair : m_Available)
+    {
+        for (auto pStmt : pair.second)
+        {
+            sqlite3_finalize(pStmt);
+        }
+    }
+
+    for (auto& pair : m_InUse)
+    {
+        sqlite3_finalize(pair.first);
+    }
+}
+
+StatementCache::Statement StatementCache::acquire(sqlite3* pDb, const std::string& query)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Key key(pDb, query);
+    auto iter = m_Available.find(key);
+    if (iter != m_Available.end() && !iter->second.empty())
+    {
+        sqlite3_stmt* pStmt = iter->second.back();
+        iter->second.pop_back();
+        m_InUse.insert(std::make_pair(pStmt, std::move(key)));
+        ++m_Stats.hits;
+        return Statement(*this, pStmt);
+    }
+
+    sqlite3_stmt* pStmt;
+    if (sqlite3_prepare_v2(pDb, query.c_str(), -1, &pStmt, 0) != SQLITE_OK)
+    {
+        throw logic_error(string("Failed to prepare sql statement (") + sqlite3_errmsg(pDb) + "): " + query);
+    }
+
+    m_InUse.insert(std::make_pair(pStmt, std::move(key)));
+    ++m_Stats.misses;
+    ++m_Stats.prepared;
+    return Statement(*this, pStmt);
+}
+
+void StatementCache::release(sqlite3_stmt* pStmt)
+{
+    // the return value of reset repeats the error of the last step, which
+    // has already been reported to the caller
+    sqlite3_reset(pStmt);
+    sqlite3_clear_bindings(pStmt);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto iter = m_InUse.find(pStmt);
+    if (iter == m_InUse.end())
+    {
+        assert(!"Released a statement that was not obtained from the cache");
+        sqlite3_finalize(pStmt);
+        return;
+    }
+
+    m_Available[iter->second].push_back(pStmt);
+    m_InUse.erase(iter);
+}
+
+void StatementCache::clear(sqlite3* pDb)
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto iter = m_Available.begin(); iter != m_Available.end();)
+    {
+        if (iter->first.first == pDb)
+        {
+            m_Stats.prepared -= iter->second.size();
+            for (auto pStmt : iter->second)
+            {
+                sqlite3_finalize(pStmt);
+            }
+
+            m_Available.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    for (auto iter = m_InUse.begin(); iter != m_InUse.end();)
+    {
+        if (iter->second.first == pDb)
+        {
+            log::warn("Finalizing statement that is still in use: %s", iter->second.second);
+            --m_Stats.prepared;
+            sqlite3_finalize(iter->first);
+            m_InUse.erase(iter++);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+}
+
+StatementCache::Stats StatementCache::getStats()
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+}
@@ -0,0 +1,92 @@
+//    Copyright (C) 2013 Dirk Vanden Boer <dirk.vdb@gmail.com>
+//
+//    This program is free software; you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation; either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program; if not, write to the Free Software
+//    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+#ifndef STATEMENT_CACHE_H
+#define STATEMENT_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include "utils/types.h"
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace Gejengel
+{
+
+// Pool of prepared statements keyed on the connection and the query text.
+// A statement is handed out exclusively until it is released, a query that is
+// still in use (e.g. in a recursive call) gets an additional statement.
+class StatementCache
+{
+public:
+    struct Stats
+    {
+        Stats() : hits(0), misses(0), prepared(0) {}
+
+        uint64_t    hits;
+        uint64_t    misses;
+        uint32_t    prepared;
+    };
+
+    // Returns its statement to the cache when it goes out of scope, also
+    // when a bind or a row callback throws. A statement that isn't reset
+    // keeps the read transaction of its connection open.
+    class Statement
+    {
+    public:
+        Statement() : m_pCache(nullptr), m_pStmt(nullptr) {}
+        Statement(StatementCache& cache, sqlite3_stmt* pStmt) : m_pCache(&cache), m_pStmt(pStmt) {}
+        Statement(Statement&& other);
+        ~Statement();
+
+        Statement& operator=(Statement&& other);
+        operator sqlite3_stmt*() const { return m_pStmt; }
+
+        void release();
+
+    private:
+        Statement(const Statement&);
+        Statement& operator=(const Statement&);
+
+        StatementCache*     m_pCache;
+        sqlite3_stmt*       m_pStmt;
+    };
+
+    StatementCache();
+    ~StatementCache();
+
+    Statement acquire(sqlite3* pDb, const std::string& query);
+    void release(sqlite3_stmt* pStmt);
+    void clear(sqlite3* pDb);
+
+    Stats getStats();
+
+private:
+    typedef std::pair<sqlite3*, std::string> Key;
+
+    std::map<Key, std::vector<sqlite3_stmt*>>   m_Available;
+    std::map<sqlite3_stmt*, Key>                m_InUse;
+    Stats                                       m_Stats;
+    std::mutex                                  m_Mutex;
+};
+
+}
+
+#endif
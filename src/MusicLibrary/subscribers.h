@@ -17,6 +17,9 @@
 #ifndef SUBSCRIBERS_H
 #define SUBSCRIBERS_H
 
+#include <vector>
+
+#include "itemid.h"
 #include "utils/types.h"
 
 namespace Gejengel
@@ -31,20 +34,32 @@ public:
     virtual ~ILibrarySubscriber() {}
 
     virtual void newTrack(const Track& track) {}
-    virtual void deletedTrack(const std::string& id) {}
+    virtual void deletedTrack(const ItemId& id) {}
     virtual void updatedTrack(const Track& track) {}
     virtual void newAlbum(const Album& album) {}
-    virtual void deletedAlbum(const std::string& id) {}
+    virtual void deletedAlbum(const ItemId& id) {}
     virtual void updatedAlbum(const Album& album) {}
     virtual void libraryCleared() {}
+
+    // called when a maintenance task removes several items at once
+    virtual void deletedTracks(const std::vector<ItemId>& ids)
+    {
+        for (auto& id : ids) deletedTrack(id);
+    }
+
+    virtual void deletedAlbums(const std::vector<ItemId>& ids)
+    {
+        for (auto& id : ids) deletedAlbum(id);
+    }
 };
 
 class IScanSubscriber
 {
 public:
     virtual ~IScanSubscriber() {}
+    // numTracks is an estimate that is refined while the library is walked
     virtual void scanStart(uint32_t numTracks) {}
-    virtual void scanUpdate(uint32_t scannedTracks) {}
+    virtual void scanUpdate(uint32_t scannedTracks, uint32_t numTracks) {}
     virtual void scanFinish() {}
     virtual void scanFailed() {}
 };
@@ -37,7 +37,7 @@ public:
     bool operator==(const Track& otherItem) const;
     friend std::ostream& operator<<(std::ostream &os, const Track& item);
 
-    std::string     albumId;
+    ItemId          albumId;
     std::string     filepath;
     std::string     artist;
     std::string     title;
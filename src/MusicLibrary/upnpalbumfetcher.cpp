@@ -97,8 +97,8 @@ void UPnPTrackFetcher::fetchTracksAsync(const std::string& containerId, utils::I
 Track UPnPTrackFetcher::itemToTrack(upnp::Item& item)
 {
     Track track;
-    track.id        = item.getObjectId();
-    track.albumId   = item.getMetaData(upnp::Property::ParentId);
+    track.id        = ItemId::fromObjectId(item.getObjectId());
+    track.albumId   = ItemId::fromObjectId(item.getMetaData(upnp::Property::ParentId));
     track.title     = item.getMetaData(upnp::Property::Title);
     track.artist    = item.getMetaData(upnp::Property::Artist);
     track.album     = item.getMetaData(upnp::Property::Album);
@@ -221,7 +221,7 @@ void UPnPAlbumFetcher::fetchAlbumsAsync(const std::string& containerId, utils::I
 Album UPnPAlbumFetcher::containerToAlbum(const upnp::Item& container)
 {
     Album album;
-    album.id            = container.getObjectId();
+    album.id            = ItemId::fromObjectId(container.getObjectId());
     album.title         = container.getTitle();
     album.trackCount    = container.getChildCount();
     album.artist        = container.getMetaData(upnp::Property::Artist);
@@ -65,44 +65,44 @@ uint32_t UPnPMusicLibrary::getAlbumCount()
     return container->getChildCount();
 }
 
-void UPnPMusicLibrary::getTrack(const std::string& id, Track& track)
+void UPnPMusicLibrary::getTrack(const ItemId& id, Track& track)
 {
-    track = m_TrackFetcher.fetchTrack(id);
+    track = m_TrackFetcher.fetchTrack(id.objectId());
 }
 
-void UPnPMusicLibrary::getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber)
+void UPnPMusicLibrary::getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber)
 {
-    m_TrackFetcher.fetchTrackAsync(id, subscriber);
+    m_TrackFetcher.fetchTrackAsync(id.objectId(), subscriber);
 }
 
-void UPnPMusicLibrary::getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void UPnPMusicLibrary::getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
-    m_TrackFetcher.fetchTracks(albumId, subscriber);
+    m_TrackFetcher.fetchTracks(albumId.objectId(), subscriber);
 }
 
-void UPnPMusicLibrary::getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void UPnPMusicLibrary::getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
-    m_TrackFetcher.fetchTracksAsync(albumId, subscriber);
+    m_TrackFetcher.fetchTracksAsync(albumId.objectId(), subscriber);
 }
 
-void UPnPMusicLibrary::getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void UPnPMusicLibrary::getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
-	m_TrackFetcher.fetchFirstTrack(albumId, subscriber);
+	m_TrackFetcher.fetchFirstTrack(albumId.objectId(), subscriber);
 }
 
-void UPnPMusicLibrary::getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber)
+void UPnPMusicLibrary::getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber)
 {
-	m_TrackFetcher.fetchFirstTrackAsync(albumId, subscriber);
+	m_TrackFetcher.fetchFirstTrackAsync(albumId.objectId(), subscriber);
 }
 
-void UPnPMusicLibrary::getAlbum(const std::string& albumId, Album& album)
+void UPnPMusicLibrary::getAlbum(const ItemId& albumId, Album& album)
 {
-    album = m_AlbumFetcher.fetchAlbum(albumId);
+    album = m_AlbumFetcher.fetchAlbum(albumId.objectId());
 }
 
-void UPnPMusicLibrary::getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber)
+void UPnPMusicLibrary::getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber)
 {
-	m_AlbumFetcher.fetchAlbumAsync(albumId, subscriber);
+	m_AlbumFetcher.fetchAlbumAsync(albumId.objectId(), subscriber);
 }
 
 void UPnPMusicLibrary::getRandomTracks(uint32_t trackCount, utils::ISubscriber<const Track&>& subscriber)
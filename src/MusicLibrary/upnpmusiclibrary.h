@@ -43,17 +43,17 @@ public:
     uint32_t getTrackCount();
     uint32_t getAlbumCount();
 
-    void getTrack(const std::string& id, Track& track);
-    void getTrackAsync(const std::string& id, utils::ISubscriber<const Track&>& subscriber);
+    void getTrack(const ItemId& id, Track& track);
+    void getTrackAsync(const ItemId& id, utils::ISubscriber<const Track&>& subscriber);
 
-    void getTracksFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
-    void getTracksFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getTracksFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getTracksFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
 
-    void getFirstTrackFromAlbum(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
-    void getFirstTrackFromAlbumAsync(const std::string& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getFirstTrackFromAlbum(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
+    void getFirstTrackFromAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Track&>& subscriber);
 
-    void getAlbum(const std::string& albumId, Album& album);
-    void getAlbumAsync(const std::string& albumId, utils::ISubscriber<const Album&>& subscriber);
+    void getAlbum(const ItemId& albumId, Album& album);
+    void getAlbumAsync(const ItemId& albumId, utils::ISubscriber<const Album&>& subscriber);
 
     void getAlbums(utils::ISubscriber<const Album&>& subscriber);
     void getAlbumsAsync(utils::ISubscriber<const Album&>& subscriber);
@@ -96,11 +96,12 @@ AlbumInfoView::AlbumInfoView(IGejengelCore& core, TrackModel& trackModel)
 }
 
 
-void AlbumInfoView::setAlbum(const std::string& albumId)
+void AlbumInfoView::setAlbum(const ItemId& albumId)
 {
     try
     {
     	m_AlbumId = albumId;
+        m_Core.getLibraryAccess().cancelRequests(*this);
         m_Core.getLibraryAccess().getAlbumAsync(albumId, *this);
 		m_CoverImage.set(m_DefaultCover);
     }
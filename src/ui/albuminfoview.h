@@ -40,7 +40,7 @@ class AlbumInfoView : public IDispatchedSubscriber<Album>
 {
 public:
     AlbumInfoView(IGejengelCore& core, TrackModel& trackModel);
-    void setAlbum(const std::string& albumId);
+    void setAlbum(const ItemId& albumId);
 
     void onDispatchedItem(const Album& album, void* pData = nullptr);
     void onDispatchedItem(const AlbumArt& albumArt, void* pData = nullptr);
@@ -73,7 +73,7 @@ private:
     Glib::RefPtr<Gdk::Pixbuf> 	m_DefaultCover;
     IGejengelCore&        		m_Core;
     IAlbumArtProvider&			m_ArtProvider;
-    std::string					m_AlbumId;
+    ItemId						m_AlbumId;
     std::vector<std::string> 	m_AlbumArtFilenames;
 };
 
@@ -68,6 +68,26 @@ void AlbumModel::getSortColumn(int32_t& id, Gtk::SortType& type)
     m_ListStore->get_sort_column_id(id, type);
 }
 
+AlbumOrder AlbumModel::getAlbumOrder()
+{
+    int32_t id = -1;
+    Gtk::SortType type = Gtk::SORT_ASCENDING;
+    m_ListStore->get_sort_column_id(id, type);
+
+    AlbumOrder order;
+    if (id == m_Columns.artist.index())
+    {
+        order.column = AlbumOrder::Artist;
+    }
+    else if (id == m_Columns.dateAdded.index())
+    {
+        order.column = AlbumOrder::DateAdded;
+    }
+
+    order.descending = (type == Gtk::SORT_DESCENDING);
+    return order;
+}
+
 void AlbumModel::clear()
 {
     Gtk::TreeModel::Children rows = m_ListStore->children();
@@ -113,13 +133,13 @@ void AlbumModel::addAlbum(const Album& album)
     fetchAlbumArt(album.id);
 }
 
-void AlbumModel::deleteAlbum(const std::string& id)
+void AlbumModel::deleteAlbum(const ItemId& id)
 {
     Gtk::TreeModel::Children rows = m_ListStore->children();
 
     for (Gtk::TreeModel::iterator iter = rows.begin(); iter != rows.end(); ++iter)
     {
-        const std::string& modelId = (*iter)[m_Columns.id];
+        const ItemId& modelId = (*iter)[m_Columns.id];
         if (modelId == id)
         {
             m_ListStore->erase(iter);
@@ -134,7 +154,7 @@ void AlbumModel::updateAlbum(const Album& album)
 
     for (Gtk::TreeModel::iterator iter = rows.begin(); iter != rows.end(); ++iter)
     {
-        const std::string& modelId = (*iter)[m_Columns.id];
+        const ItemId& modelId = (*iter)[m_Columns.id];
         if (modelId == album.id)
         {
             Glib::ustring duration;
@@ -170,7 +190,7 @@ void AlbumModel::fetchAllAlbumArt()
 
     for (Gtk::TreeModel::iterator iter = rows.begin(); iter != rows.end(); ++iter)
     {
-        const std::string& albumId = (*iter)[m_Columns.id];
+        const ItemId& albumId = (*iter)[m_Columns.id];
         m_AlbumArtProvider.getAlbumArt(albumId, *this);
     }
 }
@@ -189,7 +209,7 @@ void AlbumModel::dispatchAlbumArt()
         Gtk::TreeModel::Children rows = m_ListStore->children();
         for (Gtk::TreeModel::iterator iter = rows.begin(); iter != rows.end(); ++iter)
         {
-            const std::string& modelId = (*iter)[m_Columns.id];
+            const ItemId& modelId = (*iter)[m_Columns.id];
             if (modelId == albumArt.getAlbumId())
             {
                 try
@@ -208,13 +228,13 @@ void AlbumModel::dispatchAlbumArt()
     m_FetchedAlbumArt.clear();
 }
 
-void AlbumModel::fetchAlbumArt(const std::string& albumId)
+void AlbumModel::fetchAlbumArt(const ItemId& albumId)
 {
     Gtk::TreeModel::Children rows = m_ListStore->children();
 
     for (Gtk::TreeModel::iterator iter = rows.begin(); iter != rows.end(); ++iter)
     {
-        const std::string& modelId = (*iter)[m_Columns.id];
+        const ItemId& modelId = (*iter)[m_Columns.id];
         if (modelId == albumId)
         {
             Album album(albumId);
@@ -23,11 +23,11 @@
 #include "utils/types.h"
 #include "utils/subscriber.h"
 #include "MusicLibrary/subscribers.h"
+#include "MusicLibrary/album.h"
 
 namespace Gejengel
 {
 
-class Album;
 class AlbumArt;
 class IAlbumArtProvider;
 
@@ -45,7 +45,7 @@ public:
             add(albumArtUrl);
         }
 
-        Gtk::TreeModelColumn<std::string>                       id;
+        Gtk::TreeModelColumn<ItemId>                            id;
         Gtk::TreeModelColumn<Glib::RefPtr<Gdk::Pixbuf> >        albumArt;
         Gtk::TreeModelColumn<std::string>                       albumArtUrl;
         Gtk::TreeModelColumn<Glib::ustring>                     title;
@@ -60,12 +60,14 @@ public:
     virtual ~AlbumModel();
 
     void addAlbum(const Album& album);
-    void deleteAlbum(const std::string& id);
+    void deleteAlbum(const ItemId& id);
     void updateAlbum(const Album& album);
     void setAlbumArtSize(uint32_t size);
     const Columns& columns();
     void setSortColumn(int32_t id, Gtk::SortType type);
     void getSortColumn(int32_t& id, Gtk::SortType& type);
+    // the order of the sort column for loading the albums in pages
+    AlbumOrder getAlbumOrder();
     void clear();
 
     void onItem(const Album& album, void* pData = nullptr);
@@ -75,7 +77,7 @@ public:
     Glib::RefPtr<Gtk::ListStore> getStore() { return m_ListStore; }
 
 private:
-    void fetchAlbumArt(const std::string& albumId);
+    void fetchAlbumArt(const ItemId& albumId);
     void fetchAllAlbumArt();
     void dispatchAlbumArt();
     void clearAlbumArtCache();
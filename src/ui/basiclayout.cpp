@@ -43,9 +43,9 @@ BasicLayout::BasicLayout(Settings& settings, PlayQueueModel& playQueueModel, Tra
     m_Layout.pack1(m_LeftBox, Gtk::EXPAND);
     m_Layout.pack2(m_PlayQueueView, Gtk::SHRINK);
 
-    m_AlbumView.signalAlbumChanged.connect(sigc::mem_fun(signalAlbumChanged, &sigc::signal<void, const std::string&>::emit));
+    m_AlbumView.signalAlbumChanged.connect(sigc::mem_fun(signalAlbumChanged, &sigc::signal<void, const ItemId&>::emit));
     m_AlbumView.signalAlbumQueued.connect(sigc::mem_fun(playQueueModel.getQueue(), &PlayQueue::queueAlbum));
-    m_TrackView.signalTrackQueued.connect(sigc::mem_fun<const std::string&, int32_t>(playQueueModel.getQueue(), &PlayQueue::queueTrack));
+    m_TrackView.signalTrackQueued.connect(sigc::mem_fun<const ItemId&, int32_t>(playQueueModel.getQueue(), &PlayQueue::queueTrack));
 
     loadSettings();
 }
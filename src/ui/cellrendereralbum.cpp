@@ -40,7 +40,6 @@ extern Gtk::Button* pButton; //OMG please fix this!
 
 CellRendererAlbum::CellRendererAlbum(AlbumModel& model, MouseInfo& mousePos, bool showInfoButton)
 : Glib::ObjectBase(typeid(CellRendererAlbum))
-, m_IdProperty(*this, "id", "0")
 , m_AlbumArtProperty(*this, "album", Glib::RefPtr<Gdk::Pixbuf>())
 , m_TitleProperty(*this, "title", "")
 , m_ArtistProperty(*this, "artist", "")
@@ -130,11 +129,6 @@ void CellRendererAlbum::loadIcons()
 	}
 }
 
-Glib::PropertyProxy<Glib::ustring> CellRendererAlbum::property_id()
-{
-    return m_IdProperty.get_proxy();
-}
-
 Glib::PropertyProxy<Glib::RefPtr<Gdk::Pixbuf> > CellRendererAlbum::property_album_art()
 {
     return m_AlbumArtProperty.get_proxy();
@@ -44,7 +44,6 @@ public:
     void setSize(Size size);
     Size getSize();
 
-    Glib::PropertyProxy<Glib::ustring>              	property_id();
     Glib::PropertyProxy<Glib::RefPtr<Gdk::Pixbuf> > 	property_album_art();
     Glib::PropertyProxy<Glib::ustring>                  property_title();
     Glib::PropertyProxy<Glib::ustring>                  property_artist();
@@ -67,7 +66,6 @@ private:
     void loadIcons();
     Glib::RefPtr<Pango::Layout> createLayout(Gtk::Widget& widget) const;
 
-    Glib::Property<Glib::ustring>               	m_IdProperty;
    	Glib::Property<Glib::RefPtr<Gdk::Pixbuf> >  	m_AlbumArtProperty;
     Glib::Property<Glib::ustring>                   m_TitleProperty;
     Glib::Property<Glib::ustring>                   m_ArtistProperty;
@@ -68,7 +68,6 @@ DetailedAlbumView::DetailedAlbumView(Settings& settings, AlbumModel& albumModel,
     column->add_attribute(m_CellRenderer.property_artist(), m_AlbumModel.columns().artist);
     column->add_attribute(m_CellRenderer.property_year(), m_AlbumModel.columns().year);
     column->add_attribute(m_CellRenderer.property_genre(), m_AlbumModel.columns().genre);
-    column->add_attribute(m_CellRenderer.property_id(), m_AlbumModel.columns().id);
 
     {
         Gtk::Menu::MenuList& menuList = m_PopupMenu.items();
@@ -270,9 +269,9 @@ void DetailedAlbumView::onGetDragData(const Glib::RefPtr<Gdk::DragContext>&, Gtk
 {
     Gtk::TreeModel::Path path = *(m_TreeView.get_selection()->get_selected_rows().begin());
     Gtk::TreeModel::iterator iter = m_AlbumModel.getStore()->get_iter(path);
-    const std::string& trackId = (*iter)[m_AlbumModel.columns().id];
+    const ItemId& albumId = (*iter)[m_AlbumModel.columns().id];
     
-    selection_data.set(selection_data.get_target(), "1" + trackId);
+    selection_data.set(selection_data.get_target(), "1" + albumId.toString());
 }
 
 }
@@ -44,9 +44,10 @@ void ScanDispatcher::scanStart(uint32_t numTracks)
     sendScanStart();
 }
 
-void ScanDispatcher::scanUpdate(uint32_t scannedTracks)
+void ScanDispatcher::scanUpdate(uint32_t scannedTracks, uint32_t numTracks)
 {
     m_ScannedTracks = scannedTracks;
+    m_NumTracks = numTracks;
     sendScanUpdate();
 }
 
@@ -74,7 +75,7 @@ void ScanDispatcher::dispatchScanUpdate()
     std::lock_guard<std::mutex> lock(m_VectorMutex);
     for (size_t j = 0; j < m_Subscribers.size(); ++j)
     {
-        m_Subscribers[j]->scanUpdate(m_ScannedTracks);
+        m_Subscribers[j]->scanUpdate(m_ScannedTracks, m_NumTracks);
     }
 }
 
@@ -126,20 +127,34 @@ void LibraryChangeDispatcher::newAlbum(const Album& album)
     sendAlbumAdded();
 }
 
-void LibraryChangeDispatcher::deletedTrack(const std::string& trackId)
+void LibraryChangeDispatcher::deletedTrack(const ItemId& trackId)
 {
     std::lock_guard<std::mutex> lock(m_VectorMutex);
     m_DeletedTracks.push_back(trackId);
     sendTrackDeleted();
 }
 
-void LibraryChangeDispatcher::deletedAlbum(const std::string& albumId)
+void LibraryChangeDispatcher::deletedAlbum(const ItemId& albumId)
 {
     std::lock_guard<std::mutex> lock(m_VectorMutex);
     m_DeletedAlbums.push_back(albumId);
     sendAlbumDeleted();
 }
 
+void LibraryChangeDispatcher::deletedTracks(const std::vector<ItemId>& trackIds)
+{
+    std::lock_guard<std::mutex> lock(m_VectorMutex);
+    m_DeletedTracks.insert(m_DeletedTracks.end(), trackIds.begin(), trackIds.end());
+    sendTrackDeleted();
+}
+
+void LibraryChangeDispatcher::deletedAlbums(const std::vector<ItemId>& albumIds)
+{
+    std::lock_guard<std::mutex> lock(m_VectorMutex);
+    m_DeletedAlbums.insert(m_DeletedAlbums.end(), albumIds.begin(), albumIds.end());
+    sendAlbumDeleted();
+}
+
 void LibraryChangeDispatcher::updatedTrack(const Track& track)
 {
     std::lock_guard<std::mutex> lock(m_VectorMutex);
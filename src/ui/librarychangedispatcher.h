@@ -39,7 +39,7 @@ public:
     void addSubscriber(IScanSubscriber& subscriber);
 
     void scanStart(uint32_t numTracks);
-    void scanUpdate(uint32_t scannedTracks);
+    void scanUpdate(uint32_t scannedTracks, uint32_t numTracks);
     void scanFinish();
     void scanFailed();
 
@@ -69,11 +69,13 @@ public:
 
     void newTrack(const Track& track);
     void newAlbum(const Album& album);
-    void deletedTrack(const std::string& trackId);
-    void deletedAlbum(const std::string& albumId);
+    void deletedTrack(const ItemId& trackId);
+    void deletedAlbum(const ItemId& albumId);
     void updatedTrack(const Track& track);
     void updatedAlbum(const Album& album);
     void libraryCleared();
+    void deletedTracks(const std::vector<ItemId>& trackIds);
+    void deletedAlbums(const std::vector<ItemId>& albumIds);
 
 private:
     Glib::Dispatcher sendTrackAdded;
@@ -95,8 +97,8 @@ private:
     std::vector<ILibrarySubscriber*>    m_Subscribers;
     std::vector<Track>                  m_NewTracks;
     std::vector<Album>                  m_NewAlbums;
-    std::vector<std::string>            m_DeletedTracks;
-    std::vector<std::string>            m_DeletedAlbums;
+    std::vector<ItemId>                 m_DeletedTracks;
+    std::vector<ItemId>                 m_DeletedAlbums;
     std::vector<Track>                  m_UpdatedTracks;
     std::vector<Album>                  m_UpdatedAlbums;
     std::mutex                          m_VectorMutex;
@@ -166,6 +168,14 @@ public:
         sendFinalItem();
     }
 
+    // drops the items that were not passed to the subscriber yet
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_VectorMutex);
+        m_Items.clear();
+        m_Datas.clear();
+    }
+
 private:
     Glib::Dispatcher sendItem;
     Glib::Dispatcher sendFinalItem;
@@ -21,6 +21,7 @@
 #include "mainwindow.h"
 
 #include <cassert>
+#include <algorithm>
 #include <sstream>
 #include <glibmm/i18n.h>
 
@@ -277,12 +278,12 @@ void MainWindow::newAlbum(const Album& album)
     m_AlbumModel.addAlbum(album);
 }
 
-void MainWindow::deletedTrack(const std::string& id)
+void MainWindow::deletedTrack(const ItemId& id)
 {
     m_TrackModel.deleteTrack(id);
 }
 
-void MainWindow::deletedAlbum(const std::string& id)
+void MainWindow::deletedAlbum(const ItemId& id)
 {
     m_AlbumModel.deleteAlbum(id);
 }
@@ -302,9 +303,13 @@ void MainWindow::scanStart(uint32_t numTracks)
     m_ScanProgress.show();
 }
 
-void MainWindow::scanUpdate(uint32_t scannedTracks)
+void MainWindow::scanUpdate(uint32_t scannedTracks, uint32_t numTracks)
 {
-    m_ScanProgress.set_fraction(static_cast<double>(scannedTracks) / m_TracksToScan);
+    m_TracksToScan = numTracks;
+    if (m_TracksToScan > 0)
+    {
+        m_ScanProgress.set_fraction(std::min(1.0, static_cast<double>(scannedTracks) / m_TracksToScan));
+    }
 }
 
 void MainWindow::scanFinish()
@@ -336,10 +341,12 @@ void MainWindow::libraryCleared()
     m_Core.getPlayQueue().clear();
 }
 
-void MainWindow::selectedAlbumChanged(const std::string& albumId)
+void MainWindow::selectedAlbumChanged(const ItemId& albumId)
 {
     m_TrackModel.clear();
     m_TrackModel.setSelectedAlbumId(albumId);
+    // the tracks of a previously selected album are no longer needed
+    m_Core.getLibraryAccess().cancelRequests(m_TrackDispatcher);
     m_Core.getLibraryAccess().getTracksFromAlbumAsync(albumId, m_TrackDispatcher);
 }
 
@@ -550,13 +557,17 @@ void MainWindow::onSearchChanged(const Glib::ustring& searchString)
 
     try
     {
+        // the remaining pages of the album listing would end up in the results
+        m_Core.getLibraryAccess().cancelRequests(m_AlbumDispatcher);
+        m_AlbumDispatcher.clear();
+
         m_AlbumModel.clear();
         m_TrackModel.clear();
         m_TrackModel.clearSelectedAlbumId();
 
         if (searchString.empty())
         {
-            m_Core.getLibraryAccess().getAlbumsAsync(m_AlbumDispatcher);
+            m_Core.getLibraryAccess().getAlbumsAsync(m_AlbumDispatcher, m_AlbumModel.getAlbumOrder());
             return;
         }
 
@@ -630,7 +641,7 @@ void MainWindow::loadLocalLibrary()
         m_AlbumModel.clear();
 
         m_Core.getLibraryAccess().addLibrarySubscriber(m_Dispatcher);
-        m_Core.getLibraryAccess().getAlbumsAsync(m_AlbumDispatcher);
+        m_Core.getLibraryAccess().getAlbumsAsync(m_AlbumDispatcher, m_AlbumModel.getAlbumOrder());
         m_LibraryLoaded = true;
     }
     catch (logic_error& e)
@@ -670,7 +681,7 @@ void MainWindow::loadUPnPLibrary(const std::shared_ptr<upnp::Device>& server)
 
         UPnPLibrarySource source(server);
         m_Core.getLibraryAccess().setSource(source);
-        m_Core.getLibraryAccess().getAlbumsAsync(m_AlbumDispatcher);
+        m_Core.getLibraryAccess().getAlbumsAsync(m_AlbumDispatcher, m_AlbumModel.getAlbumOrder());
         m_LibraryLoaded = true;
     }
     catch (logic_error& e)
@@ -54,7 +54,7 @@ public:
     MainWindow(IGejengelCore& core);
     virtual ~MainWindow();
 
-    void selectedAlbumChanged(const std::string& albumId);
+    void selectedAlbumChanged(const ItemId& albumId);
     void showHideWindow();
     void run();
     void quit();
@@ -67,11 +67,11 @@ public:
     /* LibrarySubscriber interface */
     void newTrack(const Track& track);
     void newAlbum(const Album& album);
-    void deletedTrack(const std::string& id);
-    void deletedAlbum(const std::string& id);
+    void deletedTrack(const ItemId& id);
+    void deletedAlbum(const ItemId& id);
     void updatedAlbum(const Album& album);
     void scanStart(uint32_t numTracks);
-    void scanUpdate(uint32_t scannedTracks);
+    void scanUpdate(uint32_t scannedTracks, uint32_t numTracks);
     void scanFinish();
     void scanFailed();
     void libraryCleared();
@@ -236,11 +236,11 @@ bool PlayQueueView::handleExternalDrop(const Glib::RefPtr<Gdk::DragContext>& con
 
     if (data[0] == '0')
     {
-        m_PlayQueue.queueTrack(data.substr(1), dropIndex);
+        m_PlayQueue.queueTrack(ItemId::parse(data.substr(1)), dropIndex);
     }
     else if (data[0] == '1')
     {
-        m_PlayQueue.queueAlbum(data.substr(1), dropIndex);
+        m_PlayQueue.queueAlbum(ItemId::parse(data.substr(1)), dropIndex);
     }
     else
     {
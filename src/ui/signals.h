@@ -25,11 +25,11 @@
 namespace Gejengel
 {
     
-typedef sigc::signal<void, const std::string&> SignalAlbumChanged;
-typedef sigc::signal<void, const std::string&, int32_t> SignalAlbumQueued;
-typedef sigc::signal<void, const std::string&, int32_t> SignalTrackQueued;
+typedef sigc::signal<void, const ItemId&> SignalAlbumChanged;
+typedef sigc::signal<void, const ItemId&, int32_t> SignalAlbumQueued;
+typedef sigc::signal<void, const ItemId&, int32_t> SignalTrackQueued;
 typedef sigc::signal<void, const Glib::ustring&, const Glib::ustring&> SignalCellButtonClicked;
-typedef sigc::signal<void, const std::string&> SignalAlbumInfoRequested;
+typedef sigc::signal<void, const ItemId&> SignalAlbumInfoRequested;
 typedef sigc::signal<void> SignalBackButtonPressed;
 typedef sigc::signal<void> SignalClose;
 typedef sigc::signal<void> SignalModelUpdated;
@@ -44,7 +44,7 @@ SimpleAlbumLayout::SimpleAlbumLayout(IGejengelCore& core, PlayQueueModel& playQu
     m_AlbumView.signalAlbumInfoRequested.connect(sigc::mem_fun(*this, &SimpleAlbumLayout::showAlbumInfo));
     m_AlbumInfoView.signalBackButtonPressed.connect(sigc::mem_fun(*this, &SimpleAlbumLayout::showAlbums));
     m_AlbumInfoView.signalAlbumQueued.connect(sigc::mem_fun(playQueueModel.getQueue(), &PlayQueue::queueAlbum));
-    m_AlbumInfoView.signalTrackQueued.connect(sigc::mem_fun<const std::string&, int32_t>(playQueueModel.getQueue(), &PlayQueue::queueTrack));
+    m_AlbumInfoView.signalTrackQueued.connect(sigc::mem_fun<const ItemId&, int32_t>(playQueueModel.getQueue(), &PlayQueue::queueTrack));
 
     loadSettings();
 }
@@ -64,7 +64,7 @@ void SimpleAlbumLayout::saveSettings()
     m_Settings.set("SimpleAlbumLayoutDividerPos", m_AlbumQueuePane.get_position());
 }
 
-void SimpleAlbumLayout::showAlbumInfo(const std::string& albumId)
+void SimpleAlbumLayout::showAlbumInfo(const ItemId& albumId)
 {
     m_Layout.remove(m_AlbumQueuePane);
     m_Layout.add(m_AlbumInfoView.getWidget());
@@ -49,7 +49,7 @@ public:
 private:
     void loadSettings();
     void saveSettings();
-    void showAlbumInfo(const std::string& albumId);
+    void showAlbumInfo(const ItemId& albumId);
     void showAlbums();
 
     Settings&               m_Settings;
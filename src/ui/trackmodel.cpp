@@ -69,13 +69,13 @@ void TrackModel::addTrack(const Track& track)
     row[m_Columns.id]           = track.id;
 }
 
-void TrackModel::deleteTrack(const std::string& id)
+void TrackModel::deleteTrack(const ItemId& id)
 {
     TreeModel::Children rows = m_ListStore->children();
 
     for (TreeModel::iterator iter = rows.begin(); iter < rows.end(); ++iter)
     {
-        const std::string& modelId = (*iter)[m_Columns.id];
+        const ItemId& modelId = (*iter)[m_Columns.id];
         if (modelId == id)
         {
             m_ListStore->erase(iter);
@@ -89,14 +89,14 @@ void TrackModel::clear()
     m_ListStore->clear();
 }
 
-void TrackModel::setSelectedAlbumId(const std::string& albumId)
+void TrackModel::setSelectedAlbumId(const ItemId& albumId)
 {
     m_CurrentAlbumId = albumId;
 }
 
 void TrackModel::clearSelectedAlbumId()
 {
-    m_CurrentAlbumId.clear();
+    m_CurrentAlbumId = ItemId();
 }
 
 void TrackModel::setSortColumn(int32_t id, Gtk::SortType& order)
@@ -51,7 +51,7 @@ public:
     Gtk::TreeModelColumn<uint32_t>      trackNr;
     Gtk::TreeModelColumn<uint32_t>      discNr;
     Gtk::TreeModelColumn<uint32_t>      bitrate;
-    Gtk::TreeModelColumn<std::string>   id;
+    Gtk::TreeModelColumn<ItemId>        id;
 };
 
 class TrackModel : public utils::ISubscriber<const Track&>
@@ -61,11 +61,11 @@ public:
     virtual ~TrackModel();
 
     void addTrack(const Track& track);
-    void deleteTrack(const std::string& id);
+    void deleteTrack(const ItemId& id);
     const TrackModelColumns& columns();
     void clear();
 
-    void setSelectedAlbumId(const std::string& albumId);
+    void setSelectedAlbumId(const ItemId& albumId);
     void clearSelectedAlbumId();
 
     void setSortColumn(int32_t id, Gtk::SortType& order);
@@ -80,7 +80,7 @@ public:
 private:
     Glib::RefPtr<Gtk::ListStore>    m_ListStore;
     TrackModelColumns               m_Columns;
-    std::string                     m_CurrentAlbumId;
+    ItemId                          m_CurrentAlbumId;
 };
 
 }
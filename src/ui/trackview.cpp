@@ -217,7 +217,7 @@ void TrackView::queueSelected()
 
 void TrackView::queuePath(const Gtk::TreeModel::iterator& iter)
 {
-    const std::string& id = (*iter)[m_TrackModel.columns().id];
+    const ItemId& id = (*iter)[m_TrackModel.columns().id];
     signalTrackQueued.emit(id, -1);
 }
 
@@ -260,9 +260,9 @@ void TrackView::onGetDragData(const Glib::RefPtr<Gdk::DragContext>&, Gtk::Select
 {
     Gtk::TreeModel::Path path = *(m_TreeView.get_selection()->get_selected_rows().begin());
     Gtk::TreeModel::iterator iter = m_TrackModel.getStore()->get_iter(path);
-    const std::string& trackId = (*iter)[m_TrackModel.columns().id];
+    const ItemId& trackId = (*iter)[m_TrackModel.columns().id];
 
-    selection_data.set(selection_data.get_target(), "0" + trackId);
+    selection_data.set(selection_data.get_target(), "0" + trackId.toString());
 }
 
 void TrackView::onHeaderEnable(int32_t headerId)
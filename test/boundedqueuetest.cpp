@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <atomic>
+
+#include "MusicLibrary/boundedqueue.h"
+
+using namespace std;
+using namespace Gejengel;
+
+TEST(BoundedQueueTest, ItemsKeepTheirOrder)
+{
+    BoundedQueue<string> queue(4);
+    EXPECT_TRUE(queue.push("a"));
+    EXPECT_TRUE(queue.push("b"));
+    queue.close();
+
+    string item;
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ("a", item);
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ("b", item);
+    EXPECT_FALSE(queue.pop(item));
+}
+
+TEST(BoundedQueueTest, PushWaitsWhileTheQueueIsFull)
+{
+    BoundedQueue<int> queue(2);
+    std::atomic<int> pushed(0);
+
+    std::thread producer([&] () {
+        for (int i = 0; i < 5; ++i)
+        {
+            queue.push(std::move(i));
+            ++pushed;
+        }
+        queue.close();
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(2, pushed);
+
+    int item, expected = 0;
+    while (queue.pop(item))
+    {
+        EXPECT_EQ(expected++, item);
+    }
+
+    producer.join();
+    EXPECT_EQ(5, expected);
+}
+
+TEST(BoundedQueueTest, CloseWakesUpAWaitingProducer)
+{
+    BoundedQueue<int> queue(1);
+    queue.push(1);
+
+    std::thread producer([&] () {
+        EXPECT_FALSE(queue.push(2));
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    queue.close();
+    producer.join();
+
+    queue.reset();
+    int item;
+    EXPECT_TRUE(queue.push(3));
+    ASSERT_TRUE(queue.pop(item));
+    EXPECT_EQ(3, item);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <unordered_set>
+
+#include "MusicLibrary/itemid.h"
+
+using namespace std;
+using namespace Gejengel;
+
+TEST(ItemIdTest, LocalId)
+{
+    ItemId id(42);
+    EXPECT_FALSE(id.empty());
+    EXPECT_TRUE(id.isLocal());
+    EXPECT_FALSE(id.isObjectId());
+    EXPECT_EQ(42, id.toInt());
+    EXPECT_EQ("42", id.toString());
+    EXPECT_THROW(id.objectId(), logic_error);
+}
+
+TEST(ItemIdTest, EmptyId)
+{
+    ItemId id;
+    EXPECT_TRUE(id.empty());
+    EXPECT_EQ("", id.toString());
+    EXPECT_EQ(id, ItemId::parse(""));
+    EXPECT_EQ(id, ItemId::fromObjectId(""));
+    EXPECT_THROW(id.toInt(), logic_error);
+}
+
+TEST(ItemIdTest, ObjectIdsAreInterned)
+{
+    ItemId id = ItemId::fromObjectId("0$1$4");
+    EXPECT_TRUE(id.isObjectId());
+    EXPECT_EQ("0$1$4", id.objectId());
+    EXPECT_EQ(id, ItemId::fromObjectId("0$1$4"));
+    EXPECT_NE(id, ItemId::fromObjectId("0$1$5"));
+    EXPECT_THROW(id.toInt(), logic_error);
+}
+
+TEST(ItemIdTest, ParseRoundTrip)
+{
+    ItemId local(7);
+    ItemId object = ItemId::fromObjectId("123");
+
+    EXPECT_EQ("@123", object.toString());
+    EXPECT_EQ(local, ItemId::parse(local.toString()));
+    EXPECT_EQ(object, ItemId::parse(object.toString()));
+    EXPECT_NE(local, ItemId::parse("@7"));
+
+    // play queues that were saved before the prefix existed
+    EXPECT_EQ(ItemId::fromObjectId("0$1$4"), ItemId::parse("0$1$4"));
+}
+
+TEST(ItemIdTest, Hash)
+{
+    unordered_set<ItemId> ids;
+    EXPECT_TRUE(ids.insert(ItemId(1)).second);
+    EXPECT_TRUE(ids.insert(ItemId::fromObjectId("1")).second);
+    EXPECT_FALSE(ids.insert(ItemId(1)).second);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include <chrono>
+#include <fstream>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "MusicLibrary/librarywatcher.h"
+
+#define TEST_LIBRARY "watchedlibrary"
+
+using namespace std;
+using namespace Gejengel;
+
+class LibraryWatcherTest : public testing::Test
+{
+    protected:
+
+    virtual void SetUp()
+    {
+        mkdir(TEST_LIBRARY, 0755);
+        mkdir(TEST_LIBRARY "/album", 0755);
+        createFile(TEST_LIBRARY "/album/existing.mp3");
+
+        watcher.reset(new LibraryWatcher(TEST_LIBRARY, 50, [this] (const LibraryWatcher::Changes& changes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            updates.push_back(changes);
+            condition.notify_all();
+        }));
+
+        // the watches are added on the thread of the watcher
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    virtual void TearDown()
+    {
+        watcher.reset();
+        system("rm -rf " TEST_LIBRARY);
+    }
+
+    void createFile(const string& path)
+    {
+        ofstream file(path);
+        file << "data";
+    }
+
+    bool waitForUpdate(std::chrono::milliseconds timeout = std::chrono::seconds(5))
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return condition.wait_for(lock, timeout, [this] () { return !updates.empty(); });
+    }
+
+    std::unique_ptr<LibraryWatcher>     watcher;
+    std::vector<LibraryWatcher::Changes> updates;
+    std::mutex                          mutex;
+    std::condition_variable             condition;
+};
+
+TEST_F(LibraryWatcherTest, BurstOfChangesIsOneUpdate)
+{
+    createFile(TEST_LIBRARY "/album/track1.mp3");
+    createFile(TEST_LIBRARY "/album/track2.mp3");
+    createFile(TEST_LIBRARY "/album/track3.mp3");
+
+    ASSERT_TRUE(waitForUpdate());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ASSERT_EQ(1u, updates.size());
+    EXPECT_EQ(3u, updates[0].files.size());
+    EXPECT_EQ(1u, updates[0].files.count(TEST_LIBRARY "/album/track2.mp3"));
+    EXPECT_TRUE(updates[0].directories.empty());
+    EXPECT_TRUE(updates[0].removedPaths.empty());
+}
+
+TEST_F(LibraryWatcherTest, NewDirectoriesAreWatched)
+{
+    mkdir(TEST_LIBRARY "/newalbum", 0755);
+    createFile(TEST_LIBRARY "/newalbum/track1.mp3");
+    ASSERT_TRUE(waitForUpdate());
+
+    {
+        // the file is scanned with its directory
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(1u, updates[0].directories.count(TEST_LIBRARY "/newalbum"));
+        EXPECT_TRUE(updates[0].files.empty());
+        updates.clear();
+    }
+
+    createFile(TEST_LIBRARY "/newalbum/track.mp3");
+    ASSERT_TRUE(waitForUpdate());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(1u, updates[0].files.count(TEST_LIBRARY "/newalbum/track.mp3"));
+}
+
+TEST_F(LibraryWatcherTest, RemovedPaths)
+{
+    unlink(TEST_LIBRARY "/album/existing.mp3");
+    rename(TEST_LIBRARY "/album", "movedalbum");
+    ASSERT_TRUE(waitForUpdate());
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(1u, updates[0].removedPaths.count(TEST_LIBRARY "/album/existing.mp3"));
+        EXPECT_EQ(1u, updates[0].removedPaths.count(TEST_LIBRARY "/album"));
+        updates.clear();
+    }
+
+    // the directory that was moved out is no longer watched
+    createFile("movedalbum/track.mp3");
+    EXPECT_FALSE(waitForUpdate(std::chrono::milliseconds(300)));
+    system("rm -rf movedalbum");
+}
+
+TEST_F(LibraryWatcherTest, RemovedLibraryDirectory)
+{
+    system("rm -rf " TEST_LIBRARY);
+    ASSERT_TRUE(waitForUpdate());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    {
+        // the removal of the contents is covered by the library directory
+        std::lock_guard<std::mutex> lock(mutex);
+        EXPECT_EQ(1u, updates.back().removedPaths.size());
+        EXPECT_EQ(1u, updates.back().removedPaths.count(TEST_LIBRARY));
+        updates.clear();
+    }
+
+    // the whole library is checked when the directory is back
+    mkdir(TEST_LIBRARY, 0755);
+    ASSERT_TRUE(waitForUpdate(std::chrono::seconds(10)));
+
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(1u, updates[0].directories.count(TEST_LIBRARY));
+    EXPECT_TRUE(updates[0].eventsLost);
+}
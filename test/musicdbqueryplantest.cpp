@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <sqlite3.h>
+
+#include "MusicLibrary/musicdb.h"
+#include "MusicLibrary/track.h"
+#include "MusicLibrary/album.h"
+#include "MusicLibrary/albumart.h"
+
+#define TEST_DB "queryplantest.db"
+
+using namespace std;
+using namespace Gejengel;
+
+namespace
+{
+    class TrackCollector : public utils::ISubscriber<const Track&>
+    {
+    public:
+        void onItem(const Track& track, void* pData = nullptr) { tracks.push_back(track); }
+        vector<Track> tracks;
+    };
+
+    class AlbumCollector : public utils::ISubscriber<const Album&>
+    {
+    public:
+        void onItem(const Album& album, void* pData = nullptr) { albums.push_back(album); }
+        vector<Album> albums;
+    };
+
+    // Statements that run for every track during a scan or on every user
+    // interaction, they have to be answered from an index
+    const char* HOT_STATEMENTS[] =
+    {
+        "Path = ?",                     // track status and lookups by path
+        "WHERE albums.Id = ?",          // album lookups
+        "WHERE trackInfo.Id = ?",       // track lookups
+        "WHERE trackInfo.AlbumId = ?",  // the tracks of an album
+        "WHERE Hash = ?",               // album art deduplication
+        "MATCH ?",                      // search
+        "OR albums.Id",                 // the next page of an album listing
+    };
+}
+
+// Runs every operation of MusicDb on a populated database with the query
+// profiler enabled, which records the text of every statement that was
+// executed. The plans of those statements are then checked on a separate
+// connection.
+class MusicDbQueryPlanTest : public testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        remove(TEST_DB);
+        pDb = new MusicDb(TEST_DB);
+        pDb->setQueryProfiling(true);
+
+        for (int albumNr = 0; albumNr < 20; ++albumNr)
+        {
+            Album album;
+            album.title     = "Album " + std::to_string(albumNr);
+            album.artist    = "Artist " + std::to_string(albumNr % 5);
+            album.year      = 1990 + albumNr;
+
+            AlbumArt art;
+            pDb->addAlbum(album, art);
+            pDb->setAlbumArt(album.id, vector<uint8_t>(16, albumNr));
+
+            for (int trackNr = 1; trackNr <= 10; ++trackNr)
+            {
+                Track track;
+                track.title         = "Title " + std::to_string(trackNr);
+                track.album         = album.title;
+                track.artist        = album.artist;
+                track.genre         = "Genre " + std::to_string(trackNr % 3);
+                track.filepath      = "/music/" + std::to_string(albumNr) + "/" + std::to_string(trackNr) + ".mp3";
+                track.trackNr       = trackNr;
+                track.discNr        = 1;
+                track.durationInSec = 180;
+                track.modifiedTime  = 1000;
+                pDb->addTrack(track);
+            }
+        }
+
+        exerciseDatabase();
+    }
+
+    virtual void TearDown()
+    {
+        delete pDb;
+        remove(TEST_DB);
+    }
+
+    void exerciseDatabase()
+    {
+        Track track;
+        ASSERT_TRUE(pDb->getTrackWithPath("/music/3/4.mp3", track));
+        pDb->getTrack(track.id, track);
+        pDb->trackExists(track.filepath);
+        pDb->getTrackStatus(track.filepath, track.modifiedTime);
+        track.title = "Updated";
+        pDb->updateTrack(track);
+
+        Album album;
+        ASSERT_TRUE(pDb->getAlbum(track.albumId, album));
+        ItemId albumId;
+        pDb->albumExists(album.title, albumId);
+        pDb->updateAlbum(album);
+
+        AlbumArt art;
+        pDb->getAlbumArt(album, art);
+
+        TrackCollector tracks;
+        pDb->getFirstTrackFromAlbum(album.id, tracks);
+        pDb->getTracksFromAlbum(album.id, tracks);
+        pDb->getRandomTracks(5, tracks);
+        pDb->getRandomAlbum(tracks);
+
+        AlbumCollector albums;
+        pDb->getAlbums(albums);
+
+        for (auto column : { AlbumOrder::Title, AlbumOrder::Artist, AlbumOrder::DateAdded })
+        {
+            for (auto descending : { false, true })
+            {
+                Album cursor;
+                while (pDb->getAlbumPage(AlbumOrder(column, descending), cursor, 7, albums)) {}
+            }
+        }
+        pDb->searchLibrary("Title", tracks, albums);
+
+        pDb->getTrackCount();
+        pDb->getAlbumCount();
+
+        pDb->removeTrack(track.id);
+        pDb->removeNonExistingFiles();
+        pDb->removeNonExistingAlbums();
+        pDb->updateAlbumMetaData();
+    }
+
+    vector<string> getPlan(sqlite3* pSqlite, const string& statement)
+    {
+        vector<string> plan;
+
+        sqlite3_stmt* pStmt = nullptr;
+        int rc = sqlite3_prepare_v2(pSqlite, ("EXPLAIN QUERY PLAN " + statement).c_str(), -1, &pStmt, nullptr);
+        EXPECT_EQ(SQLITE_OK, rc) << sqlite3_errmsg(pSqlite) << ": " << statement;
+
+        while (rc == SQLITE_OK && sqlite3_step(pStmt) == SQLITE_ROW)
+        {
+            plan.push_back(reinterpret_cast<const char*>(sqlite3_column_text(pStmt, 3)));
+        }
+
+        sqlite3_finalize(pStmt);
+        return plan;
+    }
+
+    static bool isHot(const string& statement)
+    {
+        for (auto hot : HOT_STATEMENTS)
+        {
+            if (statement.find(hot) != string::npos)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    MusicDb* pDb;
+};
+
+TEST_F(MusicDbQueryPlanTest, HotStatementsUseAnIndex)
+{
+    auto profile = pDb->getQueryProfile();
+    ASSERT_FALSE(profile.empty());
+
+    sqlite3* pSqlite;
+    ASSERT_EQ(SQLITE_OK, sqlite3_open_v2(TEST_DB, &pSqlite, SQLITE_OPEN_READONLY, nullptr));
+
+    uint32_t hotStatements = 0;
+    for (auto& entry : profile)
+    {
+        const string& statement = entry.sql;
+
+        // schema changes and transaction control have no plan worth checking,
+        // the statements of the full text index on its shadow tables are not ours
+        if ((statement.compare(0, 6, "SELECT") != 0 && statement.compare(0, 6, "UPDATE") != 0 &&
+             statement.compare(0, 6, "DELETE") != 0 && statement.compare(0, 6, "INSERT") != 0) ||
+            statement.find("'main'.") != string::npos)
+        {
+            continue;
+        }
+
+        vector<string> plan = getPlan(pSqlite, statement);
+        if (!isHot(statement))
+        {
+            continue;
+        }
+
+        ++hotStatements;
+        for (auto& step : plan)
+        {
+            // the full text index is a virtual table, it is always scanned through its own index
+            bool fullScan = step.compare(0, 5, "SCAN ") == 0 && step.find("VIRTUAL TABLE") == string::npos;
+            EXPECT_FALSE(fullScan) << statement << std::endl << "plans: " << step;
+        }
+    }
+
+    EXPECT_GE(hotStatements, 5u);
+    sqlite3_close(pSqlite);
+}
@@ -1,13 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <set>
+#include <algorithm>
 #include <sqlite3.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "testclasses.h"
 #include "MusicLibrary/musicdb.h"
 #include "MusicLibrary/track.h"
+#include "MusicLibrary/albumart.h"
 
-#include "Utils/stringoperations.h"
-#include "Utils/numericoperations.h"
+#include "utils/stringoperations.h"
+#include "utils/numericoperations.h"
 
 #define TEST_DB "test.db"
 
@@ -20,7 +25,7 @@ class MusicDbTest : public testing::Test
 
     virtual void SetUp()
     {
-        track.id             = "1";
+        track.id             = ItemId(1);
         track.filepath       = "aPath with' quote";
         track.artist         = "anArtist";
         track.title          = "aTitle";
@@ -41,11 +46,12 @@ class MusicDbTest : public testing::Test
         album.artist    = track.albumArtist;
         album.title     = track.album;
 
-        album.coverData = std::vector<uint8_t>(16, 5);
+        AlbumArt art;
+        art.getData() = std::vector<uint8_t>(16, 5);
 
         pDb = new MusicDb(TEST_DB);
         pDb->setSubscriber(subscriber);
-        pDb->addAlbum(album);
+        pDb->addAlbum(album, art);
 
         track.albumId = album.id;
     }
@@ -112,7 +118,7 @@ TEST_F(MusicDbTest, AddTwoTracks)
     track.title = "anotherTitle";
     pDb->addTrack(track);
     ASSERT_TRUE(pDb->getTrackWithPath(track.filepath, returnedTrack));
-    track.id = "2";
+    track.id = ItemId(2);
     EXPECT_EQ(track, returnedTrack);
 }
 
@@ -128,10 +134,11 @@ TEST_F(MusicDbTest, AddIncompleteLibraryTrack)
     Album anAlbum;
     anAlbum.title = track.album;
     anAlbum.artist = track.albumArtist;
-    pDb->addAlbum(anAlbum);
+    AlbumArt art;
+    pDb->addAlbum(anAlbum, art);
+    track.albumId = anAlbum.id;
     pDb->addTrack(track);
     ASSERT_TRUE(pDb->getTrackWithPath(track.filepath, returnedTrack));
-    track.albumId = anAlbum.id;
     EXPECT_EQ(track, returnedTrack);
 }
 
@@ -151,14 +158,14 @@ TEST_F(MusicDbTest, RemoveNonExistingTracks)
 {
     pDb->addTrack(track); //non existing path
     track.filepath = TEST_DB;
-    track.id = "otherid";
+    track.id = ItemId(2);
     pDb->addTrack(track); //existing path
     EXPECT_EQ(2, pDb->getTrackCount());
 
     pDb->removeNonExistingFiles();
     EXPECT_EQ(1, pDb->getTrackCount());
     EXPECT_EQ(1, subscriber.deletedTracks.size());
-    EXPECT_EQ("1", subscriber.deletedTracks[0]);
+    EXPECT_EQ(ItemId(1), subscriber.deletedTracks[0]);
 }
 
 TEST_F(MusicDbTest, GetAlbums)
@@ -171,19 +178,15 @@ TEST_F(MusicDbTest, GetAlbums)
     track.filepath = "anotherPath";
     anAlbum.title = track.album;
     anAlbum.artist = track.albumArtist;
-    pDb->addAlbum(anAlbum);
+    AlbumArt art;
+    pDb->addAlbum(anAlbum, art);
     pDb->addTrack(track);
 
     pDb->getAlbums(albumSubscriber);
     ASSERT_EQ(2, albumSubscriber.albums.size());
 
-    Album album;
-    album.artist = "anAlbumArtist";
-    album.title = "anAlbum";
     EXPECT_EQ(album, albumSubscriber.albums[0]);
-
-    album.title = "anotherAlbum";
-    EXPECT_EQ(album, albumSubscriber.albums[1]);
+    EXPECT_EQ(anAlbum, albumSubscriber.albums[1]);
 }
 
 TEST_F(MusicDbTest, GetFirstSongFromAlbum)
@@ -195,7 +198,7 @@ TEST_F(MusicDbTest, GetFirstSongFromAlbum)
     Track otherTrack = track;
     otherTrack.filepath = "anotherPath";
     otherTrack.title = "anotherTitle";
-    otherTrack.id++;
+    otherTrack.id = ItemId(track.id.toInt() + 1);
     pDb->addTrack(otherTrack);
 
     pDb->getFirstTrackFromAlbum(track.albumId, trackSubscriber);
@@ -213,9 +216,7 @@ TEST_F(MusicDbTest, GetSongsFromAlbum)
     otherTrack.filepath = "anotherPath";
     otherTrack.title = "anotherTitle";
     
-    uint32_t id;
-    StringOperations::toNumeric(track.id, id);
-    NumericOperations::toString(++id, otherTrack.id);
+    otherTrack.id = ItemId(track.id.toInt() + 1);
     pDb->addTrack(otherTrack);    
 
     pDb->getTracksFromAlbum(track.albumId, trackSubscriber);
@@ -230,8 +231,482 @@ TEST_F(MusicDbTest, setAlbumArt)
     
     pDb->setAlbumArt(album.id, data);
 
-    pDb->getAlbumArt(album);
+    AlbumArt art;
+    ASSERT_TRUE(pDb->getAlbumArt(album, art));
+
+    ASSERT_EQ(data.size(), art.getData().size());
+    EXPECT_EQ(0, memcmp(&data.front(), &art.getData().front(), 8));
+}
+
+TEST_F(MusicDbTest, StatementCacheReusesStatements)
+{
+    pDb->addTrack(track);
+    StatementCache::Stats stats = pDb->getStatementCacheStats();
+
+    track.filepath = "anotherPath";
+    pDb->addTrack(track);
+    StatementCache::Stats newStats = pDb->getStatementCacheStats();
+
+    EXPECT_EQ(stats.misses, newStats.misses);
+    EXPECT_EQ(stats.prepared, newStats.prepared);
+    EXPECT_LT(stats.hits, newStats.hits);
+}
+
+TEST_F(MusicDbTest, StatementIsReleasedWhenTheCallbackThrows)
+{
+    class ThrowingSubscriber : public utils::ISubscriber<const Track&>
+    {
+    public:
+        void onItem(const Track&, void*) { throw logic_error("stop"); }
+    };
+
+    pDb->addTrack(track);
+
+    ThrowingSubscriber throwingSubscriber;
+    EXPECT_THROW(pDb->getTracksFromAlbum(track.albumId, throwingSubscriber), logic_error);
+    StatementCache::Stats stats = pDb->getStatementCacheStats();
+
+    TrackSubscriberMock trackSubscriber;
+    pDb->getTracksFromAlbum(track.albumId, trackSubscriber);
+    StatementCache::Stats newStats = pDb->getStatementCacheStats();
+
+    EXPECT_EQ(1u, trackSubscriber.tracks.size());
+    EXPECT_EQ(stats.prepared, newStats.prepared);
+}
+
+TEST_F(MusicDbTest, BatchNotifiesAfterCommit)
+{
+    pDb->beginBatch();
+    pDb->addTrack(track);
+    EXPECT_TRUE(pDb->trackExists(track.filepath));
+    EXPECT_EQ(0, subscriber.newTracks.size());
+
+    pDb->commitBatch();
+    ASSERT_EQ(1, subscriber.newTracks.size());
+    EXPECT_EQ(track.filepath, subscriber.newTracks[0].filepath);
+}
+
+TEST_F(MusicDbTest, SearchLibraryMatchesPrefixes)
+{
+    TrackSubscriberMock trackSubscriber;
+    AlbumSubscriberMock albumSubscriber;
+
+    pDb->addTrack(track);
+    track.filepath = "anotherPath";
+    track.title = "anotherTitle";
+    pDb->addTrack(track);
+
+    pDb->searchLibrary("anothert", trackSubscriber, albumSubscriber);
+    ASSERT_EQ(1, trackSubscriber.tracks.size());
+    EXPECT_EQ("anotherTitle", trackSubscriber.tracks[0].title);
+    ASSERT_EQ(1, albumSubscriber.albums.size());
+    EXPECT_EQ(album.title, albumSubscriber.albums[0].title);
+}
+
+TEST_F(MusicDbTest, AlbumIdFollowsRename)
+{
+    ItemId id;
+    pDb->albumExists(album.title, id);
+    EXPECT_EQ(album.id, id);
+
+    string oldTitle = album.title;
+    album.title = "renamedAlbum";
+    pDb->updateAlbum(album);
+
+    id = ItemId();
+    pDb->albumExists(oldTitle, id);
+    EXPECT_TRUE(id.empty());
+
+    pDb->albumExists(album.title, id);
+    EXPECT_EQ(album.id, id);
+}
+
+TEST_F(MusicDbTest, RemoveNonExistingAlbums)
+{
+    Album emptyAlbum;
+    emptyAlbum.title = "emptyAlbum";
+    AlbumArt art;
+    pDb->addAlbum(emptyAlbum, art);
+    pDb->addTrack(track);
+
+    pDb->removeNonExistingAlbums();
+    EXPECT_EQ(1, pDb->getAlbumCount());
+    ASSERT_EQ(1, subscriber.deletedAlbums.size());
+    EXPECT_EQ(emptyAlbum.id, subscriber.deletedAlbums[0]);
+}
+
+TEST_F(MusicDbTest, UpdateAlbumMetaData)
+{
+    pDb->addTrack(track);
+    track.filepath = "anotherPath";
+    pDb->addTrack(track);
+
+    subscriber.clearLists();
+    pDb->updateAlbumMetaData();
+
+    Album dbAlbum;
+    pDb->getAlbum(album.id, dbAlbum);
+    EXPECT_EQ(2 * track.durationInSec, dbAlbum.durationInSec);
+    ASSERT_EQ(1, subscriber.updatedAlbums.size());
+    EXPECT_EQ(dbAlbum, subscriber.updatedAlbums[0]);
+
+    // unchanged albums are not reported
+    subscriber.clearLists();
+    pDb->updateAlbumMetaData();
+    EXPECT_TRUE(subscriber.updatedAlbums.empty());
+}
+
+TEST_F(MusicDbTest, AlbumArtIsSharedBetweenAlbums)
+{
+    Album otherAlbum;
+    otherAlbum.title = "otherAlbum";
+    AlbumArt noArt;
+    pDb->addAlbum(otherAlbum, noArt);
+
+    vector<uint8_t> data(16, 7);
+    pDb->setAlbumArt(album.id, data);
+    pDb->setAlbumArt(otherAlbum.id, data);
+
+    AlbumArt art;
+    ASSERT_TRUE(pDb->getAlbumArt(otherAlbum, art));
+    EXPECT_EQ(data, art.getData());
+
+    sqlite3* pSqlite;
+    sqlite3_open(TEST_DB, &pSqlite);
+    sqlite3_stmt* pStmt;
+    sqlite3_prepare_v2(pSqlite, "SELECT COUNT(*) FROM albumArt;", -1, &pStmt, nullptr);
+    ASSERT_EQ(SQLITE_ROW, sqlite3_step(pStmt));
+    EXPECT_EQ(1, sqlite3_column_int(pStmt, 0));
+    sqlite3_finalize(pStmt);
+    sqlite3_close(pSqlite);
+}
+
+TEST_F(MusicDbTest, TrackInfoFollowsTheNormalizedTables)
+{
+    pDb->addTrack(track);
+
+    album.artist = "anotherAlbumArtist";
+    pDb->updateAlbum(album);
+
+    track.title = "anotherTitle";
+    track.artist = "anotherArtist";
+    pDb->updateTrack(track);
+
+    Track returnedTrack;
+    ASSERT_TRUE(pDb->getTrack(track.id, returnedTrack));
+    EXPECT_EQ("anotherTitle", returnedTrack.title);
+    EXPECT_EQ("anotherArtist", returnedTrack.artist);
+    EXPECT_EQ("anotherAlbumArtist", returnedTrack.albumArtist);
+
+    pDb->removeTrack(track.id);
+    EXPECT_FALSE(pDb->getTrack(track.id, returnedTrack));
+}
+
+TEST_F(MusicDbTest, SchemaIsAtLatestVersion)
+{
+    sqlite3* pSqlite;
+    sqlite3_open(TEST_DB, &pSqlite);
+
+    sqlite3_stmt* pStmt;
+    sqlite3_prepare_v2(pSqlite, "SELECT Version FROM schemaInfo;", -1, &pStmt, nullptr);
+    ASSERT_EQ(SQLITE_ROW, sqlite3_step(pStmt));
+    EXPECT_EQ(8, sqlite3_column_int(pStmt, 0));
+    sqlite3_finalize(pStmt);
+
+    sqlite3_prepare_v2(pSqlite, "SELECT COUNT(*) FROM sqlite_master WHERE type='index' AND name IN ('albumNameIndex', 'albumDateIndex', 'albumTracksIndex', 'trackInfoAlbumIndex', 'albumArtistIndex', 'trackFileIndex');", -1, &pStmt, nullptr);
+    ASSERT_EQ(SQLITE_ROW, sqlite3_step(pStmt));
+    EXPECT_EQ(6, sqlite3_column_int(pStmt, 0));
+    sqlite3_finalize(pStmt);
+
+    sqlite3_close(pSqlite);
+}
+
+TEST_F(MusicDbTest, RandomTracksAreUnique)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        track.filepath = "path" + std::to_string(i);
+        pDb->addTrack(track);
+    }
+
+    TrackSubscriberMock trackSubscriber;
+    pDb->getRandomTracks(5, trackSubscriber);
+    ASSERT_EQ(5, trackSubscriber.tracks.size());
+
+    set<ItemId> ids;
+    for (auto& randomTrack : trackSubscriber.tracks)
+    {
+        EXPECT_TRUE(ids.insert(randomTrack.id).second);
+    }
+
+    TrackSubscriberMock allTracks;
+    pDb->getRandomTracks(50, allTracks);
+    EXPECT_EQ(10, allTracks.tracks.size());
+}
+
+TEST_F(MusicDbTest, QueryProfile)
+{
+    pDb->getTrackCount();
+    EXPECT_TRUE(pDb->getQueryProfile().empty());
+
+    pDb->setQueryProfiling(true);
+    pDb->getTrackCount();
+    pDb->getTrackCount();
+    pDb->setQueryProfiling(false);
+    pDb->getTrackCount();
+
+    auto entries = pDb->getQueryProfile();
+    auto iter = std::find_if(entries.begin(), entries.end(), [] (const QueryProfiler::Entry& entry) {
+        return entry.sql == "SELECT COUNT(Id) FROM tracks;";
+    });
+
+    ASSERT_TRUE(iter != entries.end());
+    EXPECT_EQ(2, iter->calls);
+    EXPECT_EQ(2, iter->rows);
+    EXPECT_LE(iter->p50Microseconds, iter->p99Microseconds);
+    EXPECT_LE(iter->p99Microseconds, iter->maxMicroseconds);
+    EXPECT_NE(std::string::npos, pDb->dumpQueryProfile().find("SELECT COUNT(Id) FROM tracks;"));
+}
+
+TEST_F(MusicDbTest, BulkLoadRestoresIndexes)
+{
+    auto countIndexes = [] () {
+        sqlite3* pSqlite;
+        sqlite3_open(TEST_DB, &pSqlite);
+
+        sqlite3_stmt* pStmt;
+        sqlite3_prepare_v2(pSqlite, "SELECT COUNT(*) FROM sqlite_master WHERE type='index' AND name IN ('albumNameIndex', 'albumDateIndex', 'albumArtistIndex');", -1, &pStmt, nullptr);
+        int count = sqlite3_step(pStmt) == SQLITE_ROW ? sqlite3_column_int(pStmt, 0) : -1;
+        sqlite3_finalize(pStmt);
+        sqlite3_close(pSqlite);
+        return count;
+    };
+
+    EXPECT_EQ(3, countIndexes());
+
+    pDb->beginBulkLoad();
+    EXPECT_TRUE(pDb->isBulkLoadActive());
+    // the album lookups of the scan keep their indexes
+    EXPECT_EQ(2, countIndexes());
+
+    pDb->beginBatch();
+    for (int i = 0; i < 10; ++i)
+    {
+        track.filepath = "path" + std::to_string(i);
+        pDb->addTrack(track);
+    }
+    pDb->commitBatch();
+    EXPECT_EQ(MusicDb::UpToDate, pDb->getTrackStatus("path5", track.modifiedTime));
+
+    pDb->endBulkLoad();
+    EXPECT_FALSE(pDb->isBulkLoadActive());
+    EXPECT_EQ(3, countIndexes());
+    EXPECT_EQ(10, pDb->getTrackCount());
+}
+
+TEST_F(MusicDbTest, AlbumPagesFollowTheSortOrder)
+{
+    for (int i = 0; i < 10; ++i)
+    {
+        Album anAlbum;
+        anAlbum.title = "album" + std::to_string(9 - i);
+        anAlbum.artist = (i % 3 == 0) ? "" : "artist" + std::to_string(i % 2);
+        anAlbum.dateAdded = 100 + i;
+        AlbumArt art;
+        pDb->addAlbum(anAlbum, art);
+    }
+
+    for (auto column : { AlbumOrder::Title, AlbumOrder::Artist, AlbumOrder::DateAdded })
+    {
+        for (auto descending : { false, true })
+        {
+            AlbumSubscriberMock allAlbums;
+            pDb->getAlbums(allAlbums);
+            auto expected = allAlbums.albums;
+            std::stable_sort(expected.begin(), expected.end(), [&] (const Album& lhs, const Album& rhs) {
+                if (column == AlbumOrder::Title)        return descending ? lhs.title > rhs.title : lhs.title < rhs.title;
+                if (column == AlbumOrder::Artist)       return descending ? lhs.artist > rhs.artist : lhs.artist < rhs.artist;
+                return descending ? lhs.dateAdded > rhs.dateAdded : lhs.dateAdded < rhs.dateAdded;
+            });
+
+            AlbumSubscriberMock pagedAlbums;
+            Album cursor;
+            uint32_t pages = 1;
+            while (pDb->getAlbumPage(AlbumOrder(column, descending), cursor, 3, pagedAlbums))
+            {
+                ++pages;
+            }
+
+            EXPECT_EQ(4, pages);
+            ASSERT_EQ(expected.size(), pagedAlbums.albums.size());
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                switch (column)
+                {
+                case AlbumOrder::Title:
+                    EXPECT_EQ(expected[i].title, pagedAlbums.albums[i].title);
+                    break;
+                case AlbumOrder::Artist:
+                    EXPECT_EQ(expected[i].artist, pagedAlbums.albums[i].artist);
+                    break;
+                case AlbumOrder::DateAdded:
+                    EXPECT_EQ(expected[i].dateAdded, pagedAlbums.albums[i].dateAdded);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(MusicDbTest, MaintenanceReclaimsTheRemovedTracks)
+{
+    pDb->beginBatch();
+    for (int i = 0; i < 2000; ++i)
+    {
+        track.filepath = "/non/existing/path" + std::to_string(i);
+        track.title = std::string(200, 'x');
+        pDb->addTrack(track);
+    }
+    pDb->commitBatch();
+    EXPECT_FALSE(pDb->isMaintenanceDue());
+
+    pDb->removeNonExistingFiles();
+    EXPECT_TRUE(pDb->isMaintenanceDue());
+
+    EXPECT_GT(pDb->performMaintenance(10000), 0);
+    EXPECT_FALSE(pDb->isMaintenanceDue());
+}
+
+TEST_F(MusicDbTest, RemoveDirectoryRemovesTheSubdirectories)
+{
+    const char* paths[] = { "/music/a/1.mp3", "/music/a/2.mp3", "/music/a/b/3.mp3", "/music/ab/4.mp3", "/music/5.mp3" };
+    for (auto path : paths)
+    {
+        track.filepath = path;
+        pDb->addTrack(track);
+    }
+
+    Track returnedTrack;
+    ASSERT_TRUE(pDb->getTrackWithPath("/music/a/b/3.mp3", returnedTrack));
+    EXPECT_EQ("/music/a/b/3.mp3", returnedTrack.filepath);
+
+    pDb->removeDirectory("/music/a");
+    EXPECT_EQ(2, pDb->getTrackCount());
+    EXPECT_FALSE(pDb->trackExists("/music/a/1.mp3"));
+    EXPECT_FALSE(pDb->trackExists("/music/a/b/3.mp3"));
+    EXPECT_TRUE(pDb->trackExists("/music/ab/4.mp3"));
+    EXPECT_TRUE(pDb->trackExists("/music/5.mp3"));
+
+    // the directory can be filled again after its row was removed
+    track.filepath = "/music/a/1.mp3";
+    pDb->addTrack(track);
+    EXPECT_EQ(MusicDb::UpToDate, pDb->getTrackStatus("/music/a/1.mp3", track.modifiedTime));
+}
+
+TEST_F(MusicDbTest, DirectoryFingerprint)
+{
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("/music/a", 100, 3));
+
+    track.filepath = "/music/a/1.mp3";
+    pDb->addTrack(track);
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("/music/a", 100, 3));
+
+    pDb->setDirectoryFingerprint("/music/a", 100, 3);
+    EXPECT_TRUE(pDb->isDirectoryUnchanged("/music/a", 100, 3));
+    EXPECT_TRUE(pDb->isDirectoryUnchanged("/music/a/", 100, 3));
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("/music/a", 101, 3));
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("/music/a", 100, 4));
+
+    // the fingerprint goes away with the tracks of the directory
+    pDb->removeDirectory("/music/a");
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("/music/a", 100, 3));
+}
+
+TEST_F(MusicDbTest, AlbumsWithTheSameTitle)
+{
+    Album otherAlbum;
+    otherAlbum.title = album.title;
+    otherAlbum.artist = "otherAlbumArtist";
+    AlbumArt art;
+    pDb->addAlbum(otherAlbum, art);
+
+    ItemId id;
+    pDb->albumExists(album.title, album.artist, id);
+    EXPECT_EQ(album.id, id);
+    pDb->albumExists(album.title, otherAlbum.artist, id);
+    EXPECT_EQ(otherAlbum.id, id);
+
+    track.albumId = otherAlbum.id;
+    pDb->addTrack(track);
+
+    Track storedTrack;
+    ASSERT_TRUE(pDb->getTrackWithPath(track.filepath, storedTrack));
+    EXPECT_EQ(otherAlbum.id, storedTrack.albumId);
+
+    // removing one of the albums keeps the other one
+    pDb->removeNonExistingAlbums();
+    id = ItemId();
+    pDb->albumExists(album.title, id);
+    EXPECT_EQ(otherAlbum.id, id);
+}
+
+TEST_F(MusicDbTest, DirectoriesWithoutTracksKeepTheirFingerprint)
+{
+    mkdir("fingerprinted", 0755);
+    pDb->setDirectoryFingerprint("fingerprinted", 5, 2);
+    pDb->setDirectoryFingerprint("removed", 5, 2);
+
+    // the file of the track doesn't exist
+    pDb->addTrack(track);
+    pDb->removeNonExistingFiles();
+    EXPECT_EQ(0, pDb->getTrackCount());
+
+    EXPECT_TRUE(pDb->isDirectoryUnchanged("fingerprinted", 5, 2));
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("removed", 5, 2));
+
+    rmdir("fingerprinted");
+    pDb->removeDirectory("fingerprinted");
+    EXPECT_FALSE(pDb->isDirectoryUnchanged("fingerprinted", 5, 2));
+}
+
+TEST_F(MusicDbTest, AlbumDiscCount)
+{
+    album.discCount = 2;
+    pDb->updateAlbum(album);
+
+    Album storedAlbum;
+    ASSERT_TRUE(pDb->getAlbum(album.id, storedAlbum));
+    EXPECT_EQ(2, storedAlbum.discCount);
+
+    Album newAlbum;
+    newAlbum.title = "newAlbum";
+    newAlbum.discCount = 3;
+    AlbumArt art;
+    pDb->addAlbum(newAlbum, art);
+    ASSERT_TRUE(pDb->getAlbum(newAlbum.id, storedAlbum));
+    EXPECT_EQ(3, storedAlbum.discCount);
+}
+
+TEST_F(MusicDbTest, RollbackBatchDiscardsTheWrites)
+{
+    pDb->beginBatch();
+    Album newAlbum;
+    newAlbum.title = "newAlbum";
+    AlbumArt art;
+    pDb->addAlbum(newAlbum, art);
+    track.album = newAlbum.title;
+    pDb->addTrack(track);
+    pDb->rollbackBatch();
+
+    EXPECT_FALSE(pDb->isBatchActive());
+    EXPECT_EQ(0, pDb->getTrackCount());
+    EXPECT_TRUE(subscriber.newTracks.empty());
+
+    // the album id that was rolled back is forgotten
+    ItemId id;
+    pDb->albumExists(newAlbum.title, id);
+    EXPECT_TRUE(id.empty());
 
-    ASSERT_EQ(data.size(), album.coverData.size());
-    EXPECT_EQ(0, memcmp(&data.front(), &album.coverData.front(), 8));
+    // nothing to roll back
+    pDb->rollbackBatch();
 }
@@ -1,17 +1,61 @@
 #include <gtest/gtest.h>
-#include <fstream>
+#include <stdexcept>
 
-#include "MusicLibrary/filesystemmusiclibrary.h"
+#include "Core/gejengelcore.h"
+#include "Core/libraryaccess.h"
 #include "Core/playqueue.h"
 #include "Core/settings.h"
+#include "utils/fileoperations.h"
 
 using namespace std;
+using namespace utils;
 using namespace Gejengel;
 
+#define TEST_SETTINGS "test.setting"
+
+class GejengelCoreMock : public IGejengelCore
+{
+public:
+    GejengelCoreMock(Settings& settings) : settings(settings), libraryAccess(settings), playCount(0) {}
+
+    void play() { ++playCount; }
+    void pause() {}
+    void resume() {}
+    void prev() {}
+    void next() {}
+    void stop() {}
+    PlaybackState getPlaybackState() { return Stopped; }
+
+    void seek(double seconds) {}
+    double getTrackPosition() { return 0.0; }
+
+    void setVolume(int32_t volume) {}
+    int32_t getVolume() { return 0; }
+
+    void getCurrentTrack(Track& track) {}
+
+    PlayQueue& getPlayQueue() { throw logic_error("No play queue in the mock core"); }
+    Settings& getSettings() { return settings; }
+#ifdef HAVE_LIBUPNP
+    UPnPServerSettings& getUPnPServerSettings() { throw logic_error("No UPnP server settings in the mock core"); }
+#endif
+    PluginManager& getPluginManager() { throw logic_error("No plugin manager in the mock core"); }
+    IAlbumArtProvider& getAlbumArtProvider() { throw logic_error("No album art provider in the mock core"); }
+    IStatusReporter& getStatusReporter() { throw logic_error("No status reporter in the mock core"); }
+    LibraryAccess& getLibraryAccess() { return libraryAccess; }
+
+    void quitApplication() {}
+    void showHideWindow() {}
+
+    Settings&       settings;
+    LibraryAccess   libraryAccess;
+    uint32_t        playCount;
+};
+
 class PlayQueueSubscriberMock : public PlayQueueSubscriber
 {
 public:
-    void onTrackQueued(uint32_t index) { queuedIndexes.push_back(index); }
+    void onTrackQueued(uint32_t index, const Track& track) { queuedIndexes.push_back(index); }
     void onTrackRemoved(uint32_t index) { removedIndexes.push_back(index); }
     void onTrackMoved(uint32_t sourceIndex, uint32_t destIndex) { movedFromIndexes.push_back(sourceIndex); movedToIndexes.push_back(destIndex); }
     void onQueueCleared() { queueCleared = true; }
@@ -26,9 +70,16 @@ public:
 class PlayQueueTest : public testing::Test
 {
 protected:
+    // the settings are saved when they are destroyed, after the fixture
+    struct SettingsFile
+    {
+        ~SettingsFile() { fileops::deleteFile(TEST_SETTINGS); }
+    };
+
     PlayQueueTest()
-    : library(settings)
-    , q(library)
+    : settings(TEST_SETTINGS)
+    , core(settings)
+    , q(core)
     {
     }
     
@@ -37,8 +88,15 @@ protected:
         q.subscribe(qSub);
     }
 
+    Track getNextTrack()
+    {
+        auto item = std::static_pointer_cast<PlayQueueItem>(q.dequeueNextTrack());
+        return item ? item->getTrack() : Track();
+    }
+
+    SettingsFile            settingsFile;
     Settings                settings;
-    FilesystemMusicLibrary  library;
+    GejengelCoreMock        core;
     PlayQueue               q;
     PlayQueueSubscriberMock qSub;
 };
@@ -46,7 +104,7 @@ protected:
 TEST_F(PlayQueueTest, AddTrack)
 {
     Track track1, track2, track3, track4, track5;
-    track1.id = 1; track2.id = 2; track3.id = 3; track4.id = 4; track5.id = 5;
+    track1.id = ItemId(1); track2.id = ItemId(2); track3.id = ItemId(3); track4.id = ItemId(4); track5.id = ItemId(5);
     
     q.queueTrack(track1);
     q.queueTrack(track2);
@@ -54,22 +112,18 @@ TEST_F(PlayQueueTest, AddTrack)
     q.queueTrack(track4, 45); //should be added to the back
     q.queueTrack(track5, 2);
 
-    ASSERT_EQ(5, q.size());
+    ASSERT_EQ(5, q.getNumberOfTracks());
+    // only the tracks queued at the back start the playback
+    EXPECT_EQ(2, core.playCount);
 
-    Track track;
     //assert queue is now 3, 1, 5, 2, 4
-    q.getNextTrack(track);
-    ASSERT_EQ(track3, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track1, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track5, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track2, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track4, track);
-
-    ASSERT_EQ(0, q.size());
+    ASSERT_EQ(track3, getNextTrack());
+    ASSERT_EQ(track1, getNextTrack());
+    ASSERT_EQ(track5, getNextTrack());
+    ASSERT_EQ(track2, getNextTrack());
+    ASSERT_EQ(track4, getNextTrack());
+
+    ASSERT_EQ(0, q.getNumberOfTracks());
 
     ASSERT_EQ(5, qSub.queuedIndexes.size());
     ASSERT_EQ(0, qSub.queuedIndexes[0]);
@@ -82,7 +136,7 @@ TEST_F(PlayQueueTest, AddTrack)
 TEST_F(PlayQueueTest, RemoveTrack)
 {
     Track track1, track2, track3;
-    track1.id = 1; track2.id = 2; track3.id = 3;
+    track1.id = ItemId(1); track2.id = ItemId(2); track3.id = ItemId(3);
     
     q.queueTrack(track1);
     q.queueTrack(track2);
@@ -92,14 +146,11 @@ TEST_F(PlayQueueTest, RemoveTrack)
 
     ASSERT_EQ(1, qSub.removedIndexes.size());
     ASSERT_EQ(1, qSub.removedIndexes[0]);
-    ASSERT_EQ(2, q.size());
+    ASSERT_EQ(2, q.getNumberOfTracks());
 
-    Track track;
     //assert queue is now 1, 3
-    q.getNextTrack(track);
-    ASSERT_EQ(track1, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track3, track);
+    ASSERT_EQ(track1, getNextTrack());
+    ASSERT_EQ(track3, getNextTrack());
 
     ASSERT_EQ(3, qSub.removedIndexes.size());
     ASSERT_EQ(0, qSub.removedIndexes[1]);
@@ -109,7 +160,7 @@ TEST_F(PlayQueueTest, RemoveTrack)
 TEST_F(PlayQueueTest, RemoveTracks)
 {
     Track track1, track2, track3, track4, track5;
-    track1.id = 1; track2.id = 2; track3.id = 3; track4.id = 4; track5.id = 5;
+    track1.id = ItemId(1); track2.id = ItemId(2); track3.id = ItemId(3); track4.id = ItemId(4); track5.id = ItemId(5);
     
     q.queueTrack(track1);
     q.queueTrack(track2);
@@ -128,20 +179,17 @@ TEST_F(PlayQueueTest, RemoveTracks)
     ASSERT_EQ(0, qSub.removedIndexes[0]);
     ASSERT_EQ(2-1, qSub.removedIndexes[1]);
     ASSERT_EQ(4-2, qSub.removedIndexes[2]);
-    ASSERT_EQ(2, q.size());
+    ASSERT_EQ(2, q.getNumberOfTracks());
 
-    Track track;
     //assert queue is now 2, 4
-    q.getNextTrack(track);
-    ASSERT_EQ(track2, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track4, track);
+    ASSERT_EQ(track2, getNextTrack());
+    ASSERT_EQ(track4, getNextTrack());
 }
 
 TEST_F(PlayQueueTest, MoveTrack)
 {
     Track track1, track2, track3;
-    track1.id = 1; track2.id = 2; track3.id = 3;
+    track1.id = ItemId(1); track2.id = ItemId(2); track3.id = ItemId(3);
 
     q.queueTrack(track1);
     q.queueTrack(track2);
@@ -159,14 +207,10 @@ TEST_F(PlayQueueTest, MoveTrack)
     ASSERT_EQ(2, qSub.movedToIndexes[0]);
     ASSERT_EQ(0, qSub.movedToIndexes[1]);
 
-    ASSERT_EQ(3, q.size());
+    ASSERT_EQ(3, q.getNumberOfTracks());
 
-    Track track;
     //assert queue is now 3, 2, 1
-    q.getNextTrack(track);
-    ASSERT_EQ(track3, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track2, track);
-    q.getNextTrack(track);
-    ASSERT_EQ(track1, track);
+    ASSERT_EQ(track3, getNextTrack());
+    ASSERT_EQ(track2, getNextTrack());
+    ASSERT_EQ(track1, getNextTrack());
 }
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+#include "MusicLibrary/requestqueue.h"
+
+using namespace std;
+using namespace Gejengel;
+
+class RequestQueueTest : public testing::Test
+{
+protected:
+    RequestQueueTest()
+    : blocked(true)
+    {
+    }
+
+    // occupies the single worker until unblock is called
+    void block(RequestQueue& queue)
+    {
+        queue.post(RequestQueue::High, &blocked, [this] () {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] () { return !blocked; });
+        });
+    }
+
+    void unblock()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            blocked = false;
+        }
+        condition.notify_all();
+    }
+
+    // returns when the requests of the owner that were posted before have run
+    void waitFor(RequestQueue& queue, const void* pOwner)
+    {
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+        bool done = false;
+
+        queue.post(RequestQueue::Low, pOwner, [&] () {
+            std::lock_guard<std::mutex> lock(doneMutex);
+            done = true;
+            doneCondition.notify_all();
+        });
+
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCondition.wait(lock, [&] () { return done; });
+    }
+
+    void record(RequestQueue& queue, RequestQueue::Priority priority, const void* pOwner, int value)
+    {
+        queue.post(priority, pOwner, [this, value] () {
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(value);
+        });
+    }
+
+    bool                        blocked;
+    std::mutex                  mutex;
+    std::condition_variable     condition;
+    vector<int>                 order;
+};
+
+TEST_F(RequestQueueTest, HigherPriorityRunsFirst)
+{
+    RequestQueue queue(1);
+    int owner1, owner2, owner3;
+
+    block(queue);
+    record(queue, RequestQueue::Low, &owner1, 1);
+    record(queue, RequestQueue::Normal, &owner2, 2);
+    record(queue, RequestQueue::High, &owner3, 3);
+    unblock();
+
+    waitFor(queue, &owner1);
+    ASSERT_EQ(3u, order.size());
+    EXPECT_EQ(3, order[0]);
+    EXPECT_EQ(2, order[1]);
+    EXPECT_EQ(1, order[2]);
+}
+
+TEST_F(RequestQueueTest, RequestsOfAnOwnerKeepTheirOrder)
+{
+    RequestQueue queue(3);
+    int owner;
+
+    block(queue);
+    for (int i = 0; i < 50; ++i)
+    {
+        record(queue, i % 2 ? RequestQueue::High : RequestQueue::Low, &owner, i);
+    }
+    unblock();
+
+    waitFor(queue, &owner);
+    ASSERT_EQ(50u, order.size());
+    for (int i = 0; i < 50; ++i)
+    {
+        EXPECT_EQ(i, order[i]);
+    }
+}
+
+TEST_F(RequestQueueTest, Cancel)
+{
+    RequestQueue queue(1);
+    int owner1, owner2;
+
+    block(queue);
+    record(queue, RequestQueue::Normal, &owner1, 1);
+    record(queue, RequestQueue::Normal, &owner2, 2);
+    record(queue, RequestQueue::Normal, &owner1, 3);
+
+    EXPECT_EQ(2u, queue.cancel(&owner1));
+    EXPECT_EQ(0u, queue.cancel(&owner1));
+    unblock();
+
+    waitFor(queue, &owner2);
+    ASSERT_EQ(1u, order.size());
+    EXPECT_EQ(2, order[0]);
+}
+
+TEST_F(RequestQueueTest, IdleTimeStartsWhenTheLastRequestFinished)
+{
+    RequestQueue queue(1);
+
+    block(queue);
+    EXPECT_TRUE(queue.getIdleTime() == std::chrono::steady_clock::duration::zero());
+    unblock();
+
+    while (queue.getIdleTime() == std::chrono::steady_clock::duration::zero())
+    {
+        std::this_thread::yield();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_GE(queue.getIdleTime(), std::chrono::milliseconds(20));
+}
+
+TEST_F(RequestQueueTest, ShutdownWaitsForTheRunningRequest)
+{
+    RequestQueue queue(1);
+    int owner;
+    bool finished = false;
+
+    queue.post(RequestQueue::High, &owner, [&] () {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        finished = true;
+        queue.post(RequestQueue::High, &owner, [&] () { finished = false; });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    queue.shutdown();
+    EXPECT_TRUE(finished);
+    EXPECT_EQ(0u, queue.getPendingCount());
+}
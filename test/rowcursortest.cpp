@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include <sqlite3.h>
+
+#include "MusicLibrary/rowcursor.h"
+
+using namespace std;
+using namespace Gejengel;
+
+namespace
+{
+    SQL_COLUMN(Id,      uint32_t,       "Id");
+    SQL_COLUMN(Name,    sql::TextRef,   "Name");
+
+    typedef sql::Query<Name, Id> NamesQuery;
+
+    void collectRow(const NamesQuery::RowType& row, vector<pair<uint32_t, string>>& rows)
+    {
+        rows.push_back(make_pair(row.get<Id>(), row.isNull<Name>() ? string("null") : row.get<Name>().str()));
+    }
+}
+
+TEST(RowCursorTest, QueryText)
+{
+    EXPECT_EQ("SELECT Name, Id FROM names;", NamesQuery::text("FROM names;"));
+}
+
+TEST(RowCursorTest, ColumnsByTag)
+{
+    sqlite3* pDb;
+    ASSERT_EQ(SQLITE_OK, sqlite3_open(":memory:", &pDb));
+    ASSERT_EQ(SQLITE_OK, sqlite3_exec(pDb, "CREATE TABLE names(Id INTEGER, Name TEXT); INSERT INTO names VALUES (1, 'one'), (2, NULL);", nullptr, nullptr, nullptr));
+
+    sqlite3_stmt* pStmt;
+    ASSERT_EQ(SQLITE_OK, sqlite3_prepare_v2(pDb, NamesQuery::text("FROM names ORDER BY Id;").c_str(), -1, &pStmt, nullptr));
+
+    vector<pair<uint32_t, string>> rows;
+    while (sqlite3_step(pStmt) == SQLITE_ROW)
+    {
+        collectRow(NamesQuery::RowType(pStmt), rows);
+    }
+
+    sqlite3_finalize(pStmt);
+    sqlite3_close(pDb);
+
+    ASSERT_EQ(2, rows.size());
+    EXPECT_EQ(1, rows[0].first);
+    EXPECT_EQ("one", rows[0].second);
+    EXPECT_EQ(2, rows[1].first);
+    EXPECT_EQ("null", rows[1].second);
+}
@@ -1,15 +1,17 @@
 #include <gtest/gtest.h>
 #include <fstream>
+#include <sqlite3.h>
+#include <sys/stat.h>
 
 #include "MusicLibrary/scanner.h"
 #include "MusicLibrary/musicdb.h"
 #include "MusicLibrary/track.h"
-#include "Utils/fileoperations.h"
+#include "utils/fileoperations.h"
 #include "testfunctions.h"
 #include "testclasses.h"
 
 using namespace std;
-using namespace FileOperations;
+using namespace utils;
 using namespace Gejengel;
 
 #define TEST_DB "test.db"
@@ -26,7 +28,7 @@ protected:
 
     virtual void TearDown()
     {
-        deleteFile(TEST_DB);
+        fileops::deleteFile(TEST_DB);
     }
 
     string srcDir;
@@ -38,20 +40,73 @@ TEST_F(ScannerTest, ScanDirectory)
     MusicDb db(TEST_DB);
     db.setSubscriber(subscriber);
 
-<<<<<<< .working
-    Scanner scanner(db, subscriber, std::vector<std::string>());
-=======
     ScanSubscriberMock scanSubscriber;
-    Scanner scanner(db, scanSubscriber, "");
->>>>>>> .merge-right.r571
-    scanner.performScan(combinePath(srcDir, "testdata/audio"));
+    Scanner scanner(db, scanSubscriber, std::vector<std::string>());
+    scanner.performScan(fileops::combinePath(srcDir, "testdata/audio"));
 
     ASSERT_EQ(3, db.getTrackCount());
 
     Track item;
-    ASSERT_TRUE(db.getTrackWithPath(combinePath(srcDir, "testdata/audio/song1.mp3"), item));
+    ASSERT_TRUE(db.getTrackWithPath(fileops::combinePath(srcDir, "testdata/audio/song1.mp3"), item));
 
     Track expected = getTrackForSong1();
     item.id = expected.id; //ids can't be guaranteed
+    item.albumId = expected.albumId;
     EXPECT_EQ(expected, item);
 }
+
+TEST_F(ScannerTest, TrackWithoutAlbumArtistJoinsAlbumWithTheSameTitle)
+{
+    MusicDb db(TEST_DB);
+
+    // one tag reader keeps the files in order, the track with the album
+    // artist is the first of the batch
+    ScanSubscriberMock scanSubscriber;
+    Scanner scanner(db, scanSubscriber, std::vector<std::string>(), 1);
+
+    vector<string> files;
+    files.push_back(fileops::combinePath(srcDir, "testdata/mixedtags/albumartist.mp3"));
+    files.push_back(fileops::combinePath(srcDir, "testdata/mixedtags/noalbumartist.mp3"));
+    scanner.scanChanges(vector<string>(), files);
+
+    ASSERT_EQ(2, db.getTrackCount());
+    EXPECT_EQ(1, db.getAlbumCount());
+
+    Track withAlbumArtist, withoutAlbumArtist;
+    ASSERT_TRUE(db.getTrackWithPath(files[0], withAlbumArtist));
+    ASSERT_TRUE(db.getTrackWithPath(files[1], withoutAlbumArtist));
+    EXPECT_EQ(withAlbumArtist.albumId, withoutAlbumArtist.albumId);
+}
+
+TEST_F(ScannerTest, DirectoryWithAFailedTrackIsScannedAgain)
+{
+    MusicDb db(TEST_DB);
+
+    sqlite3* pSqlite;
+    sqlite3_open(TEST_DB, &pSqlite);
+    ASSERT_EQ(SQLITE_OK, sqlite3_exec(pSqlite, "CREATE TRIGGER failingTrack BEFORE INSERT ON tracks WHEN NEW.Filename = 'noalbumartist.mp3' BEGIN SELECT RAISE(ABORT, 'write failed'); END;", nullptr, nullptr, nullptr));
+    sqlite3_close(pSqlite);
+
+    ScanSubscriberMock scanSubscriber;
+    Scanner scanner(db, scanSubscriber, std::vector<std::string>());
+
+    string dir = fileops::combinePath(srcDir, "testdata/mixedtags");
+    scanner.performScan(dir);
+
+    EXPECT_EQ(1, db.getTrackCount());
+    struct stat info;
+    ASSERT_EQ(0, stat(dir.c_str(), &info));
+    EXPECT_FALSE(db.isDirectoryUnchanged(dir, static_cast<uint32_t>(info.st_mtime), 2));
+}
+
+TEST_F(ScannerTest, CancelBeforeTheScan)
+{
+    MusicDb db(TEST_DB);
+
+    ScanSubscriberMock scanSubscriber;
+    Scanner scanner(db, scanSubscriber, std::vector<std::string>());
+    scanner.cancel();
+    scanner.performScan(fileops::combinePath(srcDir, "testdata/audio"));
+
+    EXPECT_EQ(0, db.getTrackCount());
+}
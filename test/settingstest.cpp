@@ -1,44 +1,45 @@
 #include <gtest/gtest.h>
 #include <fstream>
 
-#include "Utils/fileoperations.h"
+#include "utils/fileoperations.h"
 #include "Core/settings.h"
 
-#ifdef HAVE_CONFIG_H
 #include "config.h"
-#endif
 
 using namespace std;
-using namespace FileOperations;
+using namespace utils;
 using namespace Gejengel;
 
 #define TEST_SETTINGS "test.setting"
 
+static string getDefaultDbFile()
+{
+    return fileops::combinePath(fileops::combinePath(fileops::getDataDirectory(), PACKAGE), "gejengel.db");
+}
+
 TEST(SettingsTest, LoadDefaults)
 {
     {
         Settings settings("noexist");
 
-        string home = getHomeDirectory();
-
         EXPECT_EQ("", settings.get("MusicLibrary"));
-        EXPECT_EQ(home + "/.local/share/gejengel/gejengel.db", settings.get("DBFile"));
-    #ifdef HAVE_ALSA
+        EXPECT_EQ(getDefaultDbFile(), settings.get("DBFile"));
+    #if defined HAVE_ALSA
         EXPECT_EQ("Alsa", settings.get("AudioBackend"));
-    #else
-        EXPECT_EQ("OpenAl", settings.get("AudioBackend"));
+    #elif defined HAVE_OPENAL
+        EXPECT_EQ("OpenAL", settings.get("AudioBackend"));
+    #elif defined HAVE_PULSE
+        EXPECT_EQ("PulseAudio", settings.get("AudioBackend"));
     #endif
-        EXPECT_FALSE(pathExists("noexist"));
+        EXPECT_FALSE(fileops::pathExists("noexist"));
     }
 
-    EXPECT_TRUE(pathExists("noexist"));
-    deleteFile("noexist");
+    EXPECT_TRUE(fileops::pathExists("noexist"));
+    fileops::deleteFile("noexist");
 }
 
 TEST(SettingsTest, LoadSave)
 {
-    string home = getHomeDirectory();
-
     {
         ofstream file(TEST_SETTINGS);
         file    << "MusicLibrary=/home/path oh yeah " << endl
@@ -49,7 +50,7 @@ TEST(SettingsTest, LoadSave)
         Settings settings(TEST_SETTINGS);
 
         ASSERT_EQ("/home/path oh yeah", settings.get("MusicLibrary"));
-        ASSERT_EQ(home + "/.local/share/gejengel/gejengel.db", settings.get("DBFile"));
+        ASSERT_EQ(getDefaultDbFile(), settings.get("DBFile"));
         ASSERT_EQ("alsa", settings.get("AudioBackend"));
 
         settings.set("MusicLibrary", string("/home/tata/music"));
@@ -63,5 +64,5 @@ TEST(SettingsTest, LoadSave)
         ASSERT_EQ("openal", settings.get("AudioBackend"));
     }
 
-    deleteFile(TEST_SETTINGS);
+    fileops::deleteFile(TEST_SETTINGS);
 }
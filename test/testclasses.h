@@ -4,15 +4,16 @@
 #include "MusicLibrary/subscribers.h"
 #include "MusicLibrary/track.h"
 #include "MusicLibrary/album.h"
+#include "utils/subscriber.h"
 
 class LibrarySubscriberMock : public Gejengel::ILibrarySubscriber
 {
 public:
     void newTrack(const Gejengel::Track& track) { newTracks.push_back(track); }
-    void deletedTrack(const std::string& id) { deletedTracks.push_back(id); }
+    void deletedTrack(const Gejengel::ItemId& id) { deletedTracks.push_back(id); }
     void updatedTrack(const Gejengel::Track& track) { updatedTracks.push_back(track); }
     void newAlbum(const Gejengel::Album& album) { newAlbums.push_back(album); }
-    void deletedAlbum(const std::string& id) { deletedAlbums.push_back(id); }
+    void deletedAlbum(const Gejengel::ItemId& id) { deletedAlbums.push_back(id); }
     void updatedAlbum(const Gejengel::Album& album) { updatedAlbums.push_back(album); }
 
     void clearLists()
@@ -26,25 +27,25 @@ public:
     }
 
     std::vector<Gejengel::Track> newTracks;
-    std::vector<std::string> deletedTracks;
+    std::vector<Gejengel::ItemId> deletedTracks;
     std::vector<Gejengel::Track> updatedTracks;
     std::vector<Gejengel::Album> newAlbums;
-    std::vector<std::string> deletedAlbums;
+    std::vector<Gejengel::ItemId> deletedAlbums;
     std::vector<Gejengel::Album> updatedAlbums;
 };
 
 class ScanSubscriberMock : public Gejengel::IScanSubscriber
 {
     void scanStart(uint32_t numTracks) {}
-    void scanUpdate(uint32_t scannedTracks) {}
+    void scanUpdate(uint32_t scannedTracks, uint32_t numTracks) {}
     void scanFinish() {}
     void scanFailed() {}
 };
 
-class TrackSubscriberMock : public Gejengel::ITrackSubscriber
+class TrackSubscriberMock : public utils::ISubscriber<const Gejengel::Track&>
 {
 public:
-    void onTrack(const Gejengel::Track& track)
+    void onItem(const Gejengel::Track& track, void* pData = nullptr)
     {
         tracks.push_back(track);
     }
@@ -52,10 +53,10 @@ public:
     std::vector<Gejengel::Track> tracks;
 };
 
-class AlbumSubscriberMock : public Gejengel::IAlbumSubscriber
+class AlbumSubscriberMock : public utils::ISubscriber<const Gejengel::Album&>
 {
 public:
-    void onAlbum(const Gejengel::Album& album)
+    void onItem(const Gejengel::Album& album, void* pData = nullptr)
     {
         albums.push_back(album);
     }
@@ -1,15 +1,15 @@
 #ifndef TEST_FUNCTIONS_H
 #define TEST_FUNCTIONS_H
 
-#include "Utils/fileoperations.h"
+#include "utils/fileoperations.h"
 #include "MusicLibrary/track.h"
 
 inline Gejengel::Track getTrackForSong1()
 {
     Gejengel::Track item;
-    item.id             = "2";
-    item.albumId        = "1";
-    item.filepath       = FileOperations::combinePath(getenv("srcdir"), "testdata/audio/song1.mp3");
+    item.id             = Gejengel::ItemId(2);
+    item.albumId        = Gejengel::ItemId(1);
+    item.filepath       = utils::fileops::combinePath(getenv("srcdir"), "testdata/audio/song1.mp3");
     item.artist         = "anArtist";
     item.title          = "aTitle";
     item.album          = "anAlbum";